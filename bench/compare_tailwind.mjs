@@ -0,0 +1,516 @@
+#!/usr/bin/env node
+// Runs dx-styles and the Tailwind CLI over the same synthetic TSX corpus and
+// records full-build time, single-file edit latency and watch-mode RSS as JSON.
+// Nothing is fetched: Tailwind is taken from the repo's node_modules (npm ci)
+// and dx-styles from the binaries built by make/cmake.
+//
+//   node bench/compare_tailwind.mjs [--components 500] [--out compare_results.json]
+//
+// Class names are real Tailwind utilities, and styles.toml defines each of them,
+// so both tools emit a rule for every class in the corpus. An edit is done once
+// its new class shows up in the tool's CSS on disk.
+import { spawn, spawnSync } from 'node:child_process';
+import { createRequire } from 'node:module';
+import { fileURLToPath } from 'node:url';
+import { performance } from 'node:perf_hooks';
+import fs from 'node:fs';
+import net from 'node:net';
+import os from 'node:os';
+import path from 'node:path';
+
+const repoRoot = path.resolve(path.dirname(fileURLToPath(import.meta.url)), '..');
+const FILE_FANOUT = 4;
+const EDIT_GAP_MS = 150;
+// Same marker dx_bench leaves, so either harness only wipes its own workdirs.
+const WORKDIR_MARKER = '.dx-bench';
+
+const defaults = {
+    components: 500,
+    depth: 3,
+    elements: 20,
+    classes: 4,
+    builds: 3,
+    edits: 20,
+    seed: 42,
+    timeout: 60000,
+    workdir: path.join(repoRoot, 'bench_workspace/compare'),
+    dx: path.join(repoRoot, 'dx_styles_c'),
+    generator: path.join(repoRoot, 'styles_generator'),
+    tailwind: null,
+    out: 'compare_results.json',
+};
+
+function usage() {
+    process.stderr.write(`Usage: node bench/compare_tailwind.mjs [options]
+  --components N   number of .tsx components (default ${defaults.components})
+  --depth N        directory nesting below ./src (default ${defaults.depth})
+  --elements N     elements per component (default ${defaults.elements})
+  --classes N      classes per element (default ${defaults.classes})
+  --builds N       cold full builds per tool (default ${defaults.builds})
+  --edits N        single-file edits in watch mode, at most 100 (default ${defaults.edits})
+  --seed N         corpus seed (default ${defaults.seed})
+  --timeout MS     give up on a build or edit after this long (default ${defaults.timeout})
+  --workdir DIR    scratch directory, wiped first if empty or made by a bench run
+                   (default ${defaults.workdir})
+  --dx BIN         dx-styles binary (default <repo>/dx_styles_c)
+  --generator BIN  styles_generator binary (default <repo>/styles_generator)
+  --tailwind JS    Tailwind CLI entry point (default: @tailwindcss/cli from node_modules)
+  --out FILE       JSON results (default ${defaults.out})
+`);
+}
+
+function parseArgs(argv) {
+    const cfg = { ...defaults };
+    const numeric = new Set(['components', 'depth', 'elements', 'classes', 'builds', 'edits', 'seed', 'timeout']);
+    for (let i = 0; i < argv.length; i += 2) {
+        const key = argv[i].replace(/^--/, '');
+        if (!argv[i].startsWith('--') || !(key in defaults) || i + 1 >= argv.length) return null;
+        cfg[key] = numeric.has(key) ? Number(argv[i + 1]) : argv[i + 1];
+    }
+    const positive = ['components', 'elements', 'classes', 'builds', 'timeout'];
+    if (positive.some((k) => !Number.isInteger(cfg[k]) || cfg[k] <= 0)) return null;
+    if (!Number.isInteger(cfg.depth) || cfg.depth < 0 || !Number.isInteger(cfg.edits) || cfg.edits < 0 || cfg.edits > 100) {
+        return null;
+    }
+    return cfg;
+}
+
+function mulberry32(seed) {
+    return () => {
+        seed = (seed + 0x6d2b79f5) | 0;
+        let t = Math.imul(seed ^ (seed >>> 15), 1 | seed);
+        t = (t + Math.imul(t ^ (t >>> 7), 61 | t)) ^ t;
+        return ((t ^ (t >>> 14)) >>> 0) / 4294967296;
+    };
+}
+
+// A few hundred utilities from Tailwind's default theme, each paired with the
+// declarations styles.toml gives it for dx-styles.
+function buildVocabulary() {
+    const vocabulary = [];
+    const spacing = [0, 1, 2, 3, 4, 5, 6, 8, 10, 12, 16, 20, 24, 32, 40, 48, 64, 80, 96];
+    const spacingUtilities = {
+        p: 'padding', px: 'padding-inline', py: 'padding-block', pt: 'padding-top', pr: 'padding-right',
+        pb: 'padding-bottom', pl: 'padding-left', m: 'margin', mx: 'margin-inline', my: 'margin-block',
+        mt: 'margin-top', mb: 'margin-bottom', gap: 'gap', w: 'width', h: 'height',
+    };
+    for (const [prefix, property] of Object.entries(spacingUtilities)) {
+        for (const n of spacing) vocabulary.push({ name: `${prefix}-${n}`, properties: [[property, `${n * 0.25}rem`]] });
+    }
+    const palettes = ['slate', 'gray', 'red', 'orange', 'amber', 'green', 'teal', 'sky', 'blue', 'indigo', 'pink'];
+    const shades = [50, 100, 200, 300, 400, 500, 600, 700, 800, 900, 950];
+    const colorUtilities = { bg: 'background-color', text: 'color', border: 'border-color' };
+    for (const [prefix, property] of Object.entries(colorUtilities)) {
+        for (const palette of palettes) {
+            for (const shade of shades) {
+                vocabulary.push({ name: `${prefix}-${palette}-${shade}`, properties: [[property, `var(--color-${palette}-${shade})`]] });
+            }
+        }
+    }
+    const keywords = [
+        ['flex', 'display', 'flex'], ['grid', 'display', 'grid'], ['block', 'display', 'block'],
+        ['hidden', 'display', 'none'], ['items-center', 'align-items', 'center'],
+        ['justify-between', 'justify-content', 'space-between'], ['rounded', 'border-radius', '0.25rem'],
+        ['font-bold', 'font-weight', '700'], ['italic', 'font-style', 'italic'], ['underline', 'text-decoration-line', 'underline'],
+    ];
+    for (const [name, property, value] of keywords) vocabulary.push({ name, properties: [[property, value]] });
+    return vocabulary;
+}
+
+// The corpus is generated once and written out afresh before every run, so
+// each tool starts from identical sources (dx-styles injects ids into them).
+function buildCorpus(cfg) {
+    const random = mulberry32(cfg.seed);
+    const vocabulary = buildVocabulary();
+    for (let i = vocabulary.length - 1; i > 0; i--) {
+        const j = Math.floor(random() * (i + 1));
+        [vocabulary[i], vocabulary[j]] = [vocabulary[j], vocabulary[i]];
+    }
+    // Edits introduce classes no component uses yet, so every edit has to
+    // change the emitted CSS.
+    const reserved = vocabulary.slice(0, cfg.edits).map((v) => v.name);
+    const pool = vocabulary.slice(cfg.edits).map((v) => v.name);
+    const pick = () => pool[Math.floor(random() * pool.length)];
+
+    const render = (index, extraClass) => {
+        let source = `import React from 'react';\n\nexport function Component${index}() {\n  return (\n    <div className="${pick()}">\n`;
+        for (let e = 0; e < cfg.elements; e++) {
+            const names = Array.from({ length: cfg.classes }, pick);
+            if (extraClass && e === 0) names.push(extraClass);
+            source += `      <span className="${names.join(' ')}">item ${e}</span>\n`;
+        }
+        return source + '    </div>\n  );\n}\n';
+    };
+
+    const components = [];
+    for (let i = 0; i < cfg.components; i++) {
+        let dir = 'src';
+        for (let d = 0, bucket = i; d < cfg.depth; d++, bucket = Math.floor(bucket / FILE_FANOUT)) {
+            dir += `/m${bucket % FILE_FANOUT}`;
+        }
+        components.push({ path: `${dir}/Component${i}.tsx`, source: render(i) });
+    }
+    const edits = reserved.map((cls) => {
+        const target = Math.floor(random() * cfg.components);
+        return { path: components[target].path, source: render(target, cls), cls };
+    });
+    return { vocabulary, components, edits, sentinel: components[0].source.match(/className="([^"\s]+)/)[1] };
+}
+
+function writeCorpus(corpus) {
+    fs.rmSync('src', { recursive: true, force: true });
+    for (const component of corpus.components) {
+        fs.mkdirSync(path.dirname(component.path), { recursive: true });
+        fs.writeFileSync(component.path, component.source);
+    }
+}
+
+function writeStylesToml(corpus) {
+    const lines = [];
+    for (const { name, properties } of corpus.vocabulary) {
+        lines.push(`[static_rules.${name}]`);
+        for (const [property, value] of properties) lines.push(`${property} = "${value}"`);
+        lines.push('');
+    }
+    fs.writeFileSync('styles.toml', lines.join('\n'));
+}
+
+function summarize(samples) {
+    const sorted = [...samples].sort((a, b) => a - b);
+    const at = (p) => (sorted.length ? sorted[Math.round((p / 100) * (sorted.length - 1))] : 0);
+    const round = (v) => Math.round(v * 1000) / 1000;
+    const mean = sorted.length ? sorted.reduce((a, b) => a + b, 0) / sorted.length : 0;
+    return {
+        count: sorted.length, mean: round(mean), p50: round(at(50)), p90: round(at(90)), p99: round(at(99)),
+        max: round(sorted.length ? sorted[sorted.length - 1] : 0), samples: sorted.map(round),
+    };
+}
+
+const sleep = (ms) => new Promise((resolve) => setTimeout(resolve, ms));
+
+// Resident and peak memory of a process and all of its descendants, in KB.
+// Returns null where /proc is not available.
+function treeMemory(pid) {
+    const readStatus = (p) => {
+        try {
+            const status = fs.readFileSync(`/proc/${p}/status`, 'utf8');
+            const field = (name) => Number((status.match(new RegExp(`^${name}:\\s+(\\d+)`, 'm')) || [0, 0])[1]);
+            return { rss: field('VmRSS'), hwm: field('VmHWM') };
+        } catch {
+            return null;
+        }
+    };
+    const children = (p) => {
+        try {
+            return fs.readdirSync(`/proc/${p}/task`).flatMap((tid) =>
+                fs.readFileSync(`/proc/${p}/task/${tid}/children`, 'utf8').split(' ').filter(Boolean));
+        } catch {
+            return [];
+        }
+    };
+    if (!readStatus(pid)) return null;
+    const total = { rss_kb: 0, peak_kb: 0 };
+    for (const stack = [pid]; stack.length > 0;) {
+        const p = stack.pop();
+        const status = readStatus(p);
+        if (!status) continue;
+        total.rss_kb += status.rss;
+        total.peak_kb += status.hwm;
+        stack.push(...children(p));
+    }
+    return total;
+}
+
+function waitForExit(child, timeout) {
+    if (child.exitCode !== null || child.signalCode !== null) return Promise.resolve();
+    return new Promise((resolve) => {
+        const timer = setTimeout(() => {
+            child.kill('SIGKILL');
+            resolve();
+        }, timeout);
+        child.once('exit', () => {
+            clearTimeout(timer);
+            resolve();
+        });
+    });
+}
+
+// Resolves once `file` contains a rule for `cls`. Directory events drive the
+// checks; the interval only covers events a platform may coalesce or drop.
+function waitForRule(file, cls, timeout) {
+    const pattern = new RegExp(`\\.${cls.replace(/[-]/g, '\\-')}[\\s{,]`);
+    return new Promise((resolve, reject) => {
+        const check = () => {
+            let css;
+            try {
+                css = fs.readFileSync(file, 'utf8');
+            } catch {
+                return;
+            }
+            if (pattern.test(css)) finish(null);
+        };
+        const watcher = fs.watch(path.dirname(file), check);
+        const interval = setInterval(check, 20);
+        const timer = setTimeout(() => finish(new Error(`'${cls}' did not reach ${path.basename(file)} within ${timeout} ms`)), timeout);
+        const finish = (error) => {
+            watcher.close();
+            clearInterval(interval);
+            clearTimeout(timer);
+            error ? reject(error) : resolve(performance.now());
+        };
+        check();
+    });
+}
+
+function ping(socketPath) {
+    return new Promise((resolve) => {
+        const socket = net.createConnection(socketPath);
+        let reply = '';
+        socket.on('connect', () => socket.write('PING\n'));
+        socket.on('data', (chunk) => {
+            reply += chunk;
+            if (reply.includes('pong')) {
+                socket.destroy();
+                resolve(true);
+            }
+        });
+        socket.on('error', () => resolve(false));
+        socket.on('close', () => resolve(reply.includes('pong')));
+    });
+}
+
+// dx-styles has no one-shot mode: it builds, then starts watching. With
+// --daemon the IPC socket only opens after the initial build, so the first
+// answered PING marks the end of it.
+const dxTool = (cfg, socketPath) => ({
+    name: 'dx-styles',
+    output: 'styles.css',
+    spawnWatcher() {
+        fs.rmSync(socketPath, { force: true });
+        return spawn(cfg.dx, ['--daemon', socketPath], { stdio: 'ignore' });
+    },
+    async waitReady(child, timeout) {
+        const deadline = performance.now() + timeout;
+        while (performance.now() < deadline) {
+            if (child.exitCode !== null) throw new Error(`dx-styles exited with code ${child.exitCode}`);
+            if (await ping(socketPath)) return performance.now();
+            await sleep(5);
+        }
+        throw new Error(`dx-styles did not answer within ${timeout} ms`);
+    },
+    async build(timeout) {
+        const started = performance.now();
+        const child = this.spawnWatcher();
+        try {
+            return (await this.waitReady(child, timeout)) - started;
+        } finally {
+            await this.stop(child);
+        }
+    },
+    stop(child) {
+        child.kill('SIGINT');
+        return waitForExit(child, 5000);
+    },
+});
+
+// The CLI is started through the running node so the measured pid is the
+// Tailwind process itself rather than a shell shim. stdin stays open because
+// --watch exits when it closes.
+const tailwindTool = (cfg, cli) => ({
+    name: 'tailwindcss',
+    output: 'tailwind.css',
+    spawnWatcher() {
+        return spawn(process.execPath, [cli, '-i', 'input.css', '-o', this.output, '--watch'],
+                     { stdio: ['pipe', 'ignore', 'ignore'] });
+    },
+    waitReady(child, timeout, sentinel) {
+        return waitForRule(path.resolve(this.output), sentinel, timeout);
+    },
+    async build(timeout) {
+        const started = performance.now();
+        const child = spawn(process.execPath, [cli, '-i', 'input.css', '-o', this.output], { stdio: 'ignore' });
+        await waitForExit(child, timeout);
+        if (child.exitCode !== 0) throw new Error(`tailwindcss exited with ${child.exitCode ?? child.signalCode}`);
+        return performance.now() - started;
+    },
+    stop(child) {
+        child.stdin.end();
+        child.kill('SIGTERM');
+        return waitForExit(child, 5000);
+    },
+});
+
+async function measureTool(tool, cfg, corpus) {
+    const result = { available: true, full_build_ms: null, edit_latency_ms: null, watch_memory_kb: null };
+    const builds = [];
+    for (let i = 0; i < cfg.builds; i++) {
+        writeCorpus(corpus);
+        fs.rmSync(tool.output, { force: true });
+        builds.push(await tool.build(cfg.timeout));
+    }
+    result.full_build_ms = summarize(builds);
+
+    writeCorpus(corpus);
+    fs.rmSync(tool.output, { force: true });
+    const child = tool.spawnWatcher();
+    try {
+        await tool.waitReady(child, cfg.timeout, corpus.sentinel);
+        await sleep(500);
+        const idle = treeMemory(child.pid);
+
+        const latencies = [];
+        let maxRss = idle ? idle.rss_kb : 0;
+        for (const edit of corpus.edits) {
+            const done = waitForRule(path.resolve(tool.output), edit.cls, cfg.timeout);
+            const started = performance.now();
+            fs.writeFileSync(edit.path, edit.source);
+            latencies.push((await done) - started);
+            const sample = treeMemory(child.pid);
+            if (sample) maxRss = Math.max(maxRss, sample.rss_kb);
+            await sleep(EDIT_GAP_MS);
+        }
+        const final = treeMemory(child.pid);
+        result.edit_latency_ms = summarize(latencies);
+        // peak_rss is the kernel's high-water mark, which also covers the
+        // initial build the watcher ran before the first edit.
+        result.watch_memory_kb = idle && final ? {
+            idle_rss: idle.rss_kb,
+            final_rss: final.rss_kb,
+            max_sampled_rss: Math.max(maxRss, final.rss_kb),
+            peak_rss: final.peak_kb,
+        } : null;
+    } finally {
+        await tool.stop(child);
+    }
+    return result;
+}
+
+// Refuses to wipe a directory the benchmark did not create itself.
+function prepareWorkdir(workdir) {
+    let entries = null;
+    try {
+        if (!fs.statSync(workdir).isDirectory()) return `'${workdir}' is not a directory`;
+        entries = fs.readdirSync(workdir);
+    } catch (error) {
+        if (error.code !== 'ENOENT') return `${workdir}: ${error.message}`;
+    }
+    if (entries && entries.length > 0 && !entries.includes(WORKDIR_MARKER)) {
+        return `Refusing to wipe '${workdir}': it is not empty and has no ${WORKDIR_MARKER} marker`;
+    }
+    fs.rmSync(workdir, { recursive: true, force: true });
+    fs.mkdirSync(workdir, { recursive: true });
+    fs.writeFileSync(path.join(workdir, WORKDIR_MARKER), '');
+    return null;
+}
+
+function resolveTailwind(cfg) {
+    const requireFromRepo = createRequire(path.join(repoRoot, 'package.json'));
+    let cli = cfg.tailwind ? path.resolve(cfg.tailwind) : null;
+    let version = null;
+    if (!cli) {
+        try {
+            const manifestPath = requireFromRepo.resolve('@tailwindcss/cli/package.json');
+            const manifest = JSON.parse(fs.readFileSync(manifestPath, 'utf8'));
+            const bin = typeof manifest.bin === 'string' ? manifest.bin : Object.values(manifest.bin)[0];
+            cli = path.join(path.dirname(manifestPath), bin);
+            version = manifest.version;
+        } catch {
+            return { error: '@tailwindcss/cli is not installed; run `npm ci` in the repo root' };
+        }
+    }
+    if (!fs.existsSync(cli)) return { error: `no Tailwind CLI at '${cli}'` };
+
+    // An absolute import keeps the work directory free to live outside the repo.
+    let entry = 'tailwindcss';
+    try {
+        entry = path.join(path.dirname(requireFromRepo.resolve('tailwindcss/package.json')), 'index.css');
+    } catch {
+        // Left to the CLI's own resolution from the work directory.
+    }
+    return { cli, version, entry };
+}
+
+async function main() {
+    const cfg = parseArgs(process.argv.slice(2));
+    if (!cfg) {
+        usage();
+        process.exit(1);
+    }
+    const output = path.resolve(cfg.out);
+    for (const key of ['dx', 'generator']) {
+        cfg[key] = path.resolve(cfg[key]);
+    }
+    const tailwind = resolveTailwind(cfg);
+
+    const corpus = buildCorpus(cfg);
+    const workdirError = prepareWorkdir(cfg.workdir);
+    if (workdirError) {
+        process.stderr.write(`${workdirError}\n`);
+        process.exit(1);
+    }
+    process.chdir(cfg.workdir);
+    writeStylesToml(corpus);
+    if (!tailwind.error) {
+        // source(none) keeps Tailwind to the corpus, the same files dx-styles scans.
+        fs.writeFileSync('input.css', `@import "${tailwind.entry}" source(none);\n@source "./src";\n`);
+    }
+
+    const results = {
+        config: {
+            components: cfg.components, depth: cfg.depth, elements: cfg.elements, classes_per_element: cfg.classes,
+            vocabulary: corpus.vocabulary.length, builds: cfg.builds, edits: cfg.edits, seed: cfg.seed,
+        },
+        environment: {
+            platform: `${os.platform()} ${os.release()}`, arch: os.arch(), cpus: os.cpus().length,
+            cpu_model: os.cpus()[0]?.model ?? null, total_memory_mb: Math.round(os.totalmem() / 1048576),
+            node: process.version, tailwindcss: tailwind.version ?? null,
+        },
+        tools: {},
+    };
+
+    const socketPath = path.join(os.tmpdir(), `dx-compare-${process.pid}.sock`);
+    const tools = [];
+    if (!fs.existsSync(cfg.dx) || !fs.existsSync(cfg.generator)) {
+        results.tools['dx-styles'] = { available: false, error: `build ${path.basename(cfg.dx)} and styles_generator first` };
+    } else {
+        const started = performance.now();
+        const generated = spawnSync(cfg.generator, ['styles.toml'], { stdio: 'ignore' });
+        if (generated.status !== 0) {
+            results.tools['dx-styles'] = { available: false, error: 'styles_generator failed' };
+        } else {
+            results.tools['dx-styles'] = { available: true, generator_ms: Math.round((performance.now() - started) * 1000) / 1000 };
+            tools.push(dxTool(cfg, socketPath));
+        }
+    }
+    if (tailwind.error) {
+        results.tools.tailwindcss = { available: false, error: tailwind.error };
+    } else {
+        tools.push(tailwindTool(cfg, tailwind.cli));
+    }
+
+    for (const tool of tools) {
+        process.stderr.write(`${tool.name}: ${cfg.builds} builds, ${cfg.edits} edits...\n`);
+        try {
+            Object.assign(results.tools[tool.name] ??= {}, await measureTool(tool, cfg, corpus));
+        } catch (error) {
+            Object.assign(results.tools[tool.name] ??= {}, { available: true, error: error.message });
+        }
+    }
+    fs.rmSync(socketPath, { force: true });
+
+    fs.writeFileSync(output, JSON.stringify(results, null, 2) + '\n');
+    for (const [name, r] of Object.entries(results.tools)) {
+        if (r.error) {
+            process.stderr.write(`${name}: ${r.error}\n`);
+            continue;
+        }
+        process.stderr.write(`${name}: full build p50 ${r.full_build_ms.p50.toFixed(2)}ms, edit p50 ${r.edit_latency_ms.p50.toFixed(2)}ms ` +
+                             `p99 ${r.edit_latency_ms.p99.toFixed(2)}ms, watch rss ${r.watch_memory_kb?.final_rss ?? '?'} KB\n`);
+    }
+    process.stderr.write(`-> ${output}\n`);
+}
+
+main().catch((error) => {
+    process.stderr.write(`${error.stack ?? error}\n`);
+    process.exit(1);
+});
@@ -0,0 +1,370 @@
+#define _XOPEN_SOURCE 700
+#include <dirent.h>
+#include <errno.h>
+#include <ftw.h>
+#include <limits.h>
+#include <sys/resource.h>
+
+#include "common.h"
+#include "watcher.h"
+#include "file_io.h"
+
+#define FILE_FANOUT 4
+// Dropped into every workspace the bench creates; only a directory carrying
+// it (or an empty one) is ever wiped.
+#define WORKDIR_MARKER ".dx-bench"
+
+typedef struct {
+    int components;
+    int depth;
+    int elements;
+    int classes_per_element;
+    int vocabulary;
+    int rules;
+    int edits;
+    int bursts;
+    int burst_percent;
+    unsigned int seed;
+    const char* workdir;
+    const char* generator;
+    const char* output;
+} BenchConfig;
+
+typedef struct {
+    double* samples;
+    size_t count;
+} Samples;
+
+static char** component_paths = NULL;
+
+// Class names are spread over many leading letters so the generated ids
+// (initials of the class list) collide about as often as in a real project.
+static const char* class_stems[] = {
+    "align", "bg", "border", "cursor", "display", "flex", "gap", "height",
+    "inset", "justify", "kerning", "leading", "margin", "nowrap", "opacity", "padding",
+    "quote", "rounded", "shadow", "text", "underline", "visible", "width", "xl",
+    "y-axis", "z-index"
+};
+#define CLASS_STEM_COUNT (sizeof(class_stems) / sizeof(class_stems[0]))
+
+static void class_name(char* buffer, size_t size, int word) {
+    snprintf(buffer, size, "%s-%d", class_stems[word % CLASS_STEM_COUNT], word / (int)CLASS_STEM_COUNT);
+}
+
+static double elapsed_ms(uint64_t start) {
+    return (uv_hrtime() - start) / 1e6;
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const Samples* s, double p) {
+    if (s->count == 0) return 0.0;
+    size_t index = (size_t)(p / 100.0 * (s->count - 1) + 0.5);
+    return s->samples[index];
+}
+
+static int remove_entry(const char* path, const struct stat* sb, int flag, struct FTW* ftwbuf) {
+    (void)sb; (void)flag; (void)ftwbuf;
+    return remove(path);
+}
+
+static bool is_empty_dir(const char* path) {
+    DIR* dir = opendir(path);
+    if (!dir) return false;
+    struct dirent* entry;
+    bool empty = true;
+    while (empty && (entry = readdir(dir))) {
+        empty = strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0;
+    }
+    closedir(dir);
+    return empty;
+}
+
+static int prepare_workdir(const char* workdir) {
+    struct stat st;
+    if (stat(workdir, &st) == 0) {
+        char marker[PATH_MAX];
+        snprintf(marker, sizeof(marker), "%s/%s", workdir, WORKDIR_MARKER);
+        if (!S_ISDIR(st.st_mode)) {
+            fprintf(stderr, "%s'%s' is not a directory%s\n", KRED, workdir, KNRM);
+            return -1;
+        }
+        if (access(marker, F_OK) != 0 && !is_empty_dir(workdir)) {
+            fprintf(stderr, "%sRefusing to wipe '%s': it is not empty and has no %s marker%s\n",
+                    KRED, workdir, WORKDIR_MARKER, KNRM);
+            return -1;
+        }
+        nftw(workdir, remove_entry, 64, FTW_DEPTH | FTW_PHYS);
+    } else if (errno != ENOENT) {
+        fprintf(stderr, "%sCannot use workdir '%s': %s%s\n", KRED, workdir, strerror(errno), KNRM);
+        return -1;
+    }
+
+    if (mkdir(workdir, 0755) != 0 || chdir(workdir) != 0) {
+        fprintf(stderr, "%sCannot create workdir '%s': %s%s\n", KRED, workdir, strerror(errno), KNRM);
+        return -1;
+    }
+    FILE* fp = fopen(WORKDIR_MARKER, "w");
+    CHECK(fp);
+    fclose(fp);
+    return 0;
+}
+
+static void make_dirs(char* path) {
+    for (char* p = path + 1; *p; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            mkdir(path, 0755);
+            *p = '/';
+        }
+    }
+}
+
+static void write_component(const BenchConfig* cfg, int index, int revision) {
+    FILE* fp = fopen(component_paths[index], "w");
+    CHECK(fp);
+
+    char name[64];
+    class_name(name, sizeof(name), index % cfg->vocabulary);
+    fprintf(fp, "import React from 'react';\n\nexport function Component%d() {\n  return (\n    <div className=\"%s\">\n",
+            index, name);
+    for (int e = 0; e < cfg->elements; e++) {
+        fprintf(fp, "      <span className=\"");
+        for (int c = 0; c < cfg->classes_per_element; c++) {
+            int word = (int)((index * 131u + e * 31u + c * 7u + revision * 17u + (unsigned)rand()) % cfg->vocabulary);
+            class_name(name, sizeof(name), word);
+            fprintf(fp, "%s%s", c == 0 ? "" : " ", name);
+        }
+        fprintf(fp, "\">item %d</span>\n", e);
+    }
+    fprintf(fp, "    </div>\n  );\n}\n");
+    fclose(fp);
+}
+
+static void synthesize_tree(const BenchConfig* cfg) {
+    component_paths = calloc(cfg->components, sizeof(char*));
+    CHECK(component_paths);
+
+    for (int i = 0; i < cfg->components; i++) {
+        char path[512];
+        int len = snprintf(path, sizeof(path), "./src");
+        int bucket = i;
+        for (int d = 0; d < cfg->depth; d++) {
+            len += snprintf(path + len, sizeof(path) - len, "/m%d", bucket % FILE_FANOUT);
+            bucket /= FILE_FANOUT;
+        }
+        snprintf(path + len, sizeof(path) - len, "/Component%d.tsx", i);
+        make_dirs(path);
+        component_paths[i] = strdup(path);
+        CHECK(component_paths[i]);
+        write_component(cfg, i, 0);
+    }
+
+    static const char* properties[] = { "display", "color", "padding", "margin", "background-color", "border-radius" };
+    static const char* values[] = { "flex", "white", "4px", "0 auto", "#0f172a", "8px" };
+
+    FILE* fp = fopen("styles.toml", "w");
+    CHECK(fp);
+    for (int r = 0; r < cfg->rules; r++) {
+        char name[64];
+        class_name(name, sizeof(name), r);
+        fprintf(fp, "[static_rules.%s]\n", name);
+        int count = 2 + r % 3;
+        for (int p = 0; p < count; p++) {
+            int which = (r + p) % 6;
+            fprintf(fp, "%s = \"%s\"\n", properties[which], values[(which + r) % 6]);
+        }
+        fprintf(fp, "\n");
+    }
+    fclose(fp);
+}
+
+static double run_generator(const BenchConfig* cfg) {
+    char command[PATH_MAX + 64];
+    snprintf(command, sizeof(command), "\"%s\" styles.toml > /dev/null", cfg->generator);
+    uint64_t start = uv_hrtime();
+    if (system(command) != 0) {
+        fprintf(stderr, "%sstyles_generator failed: %s%s\n", KRED, cfg->generator, KNRM);
+        exit(1);
+    }
+    return elapsed_ms(start);
+}
+
+// Hands the cycle the edited files, as the watcher does after a save.
+static void run_edit_cycle(int first, int touched, int components) {
+    FileList changed = {0};
+    changed.capacity = (size_t)touched;
+    changed.paths = malloc(changed.capacity * sizeof(char*));
+    CHECK(changed.paths);
+    for (int i = 0; i < touched; i++) {
+        changed.paths[changed.count] = strdup(component_paths[(first + i) % components]);
+        CHECK(changed.paths[changed.count]);
+        changed.count++;
+    }
+    run_changed_files_cycle(component_paths[first], &changed);
+    free_file_list(&changed);
+}
+
+static void measure_edits(const BenchConfig* cfg, Samples* out) {
+    out->samples = calloc(cfg->edits, sizeof(double));
+    CHECK(out->samples);
+    for (int i = 0; i < cfg->edits; i++) {
+        int target = rand() % cfg->components;
+        write_component(cfg, target, i + 1);
+        uint64_t start = uv_hrtime();
+        run_edit_cycle(target, 1, cfg->components);
+        out->samples[out->count++] = elapsed_ms(start);
+    }
+    qsort(out->samples, out->count, sizeof(double), compare_doubles);
+}
+
+static void measure_bursts(const BenchConfig* cfg, Samples* out) {
+    out->samples = calloc(cfg->bursts, sizeof(double));
+    CHECK(out->samples);
+    int touched = cfg->components * cfg->burst_percent / 100;
+    if (touched < 1) touched = 1;
+
+    for (int b = 0; b < cfg->bursts; b++) {
+        int first = rand() % cfg->components;
+        for (int i = 0; i < touched; i++) {
+            write_component(cfg, (first + i) % cfg->components, cfg->edits + b + 1);
+        }
+        uint64_t start = uv_hrtime();
+        run_edit_cycle(first, touched, cfg->components);
+        out->samples[out->count++] = elapsed_ms(start);
+    }
+    qsort(out->samples, out->count, sizeof(double), compare_doubles);
+}
+
+static void write_samples_json(FILE* fp, const char* name, const Samples* s) {
+    double sum = 0;
+    for (size_t i = 0; i < s->count; i++) sum += s->samples[i];
+    fprintf(fp, "  \"%s\": {\"count\": %zu, \"mean\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f},\n",
+            name, s->count, s->count ? sum / s->count : 0.0,
+            percentile(s, 50), percentile(s, 90), percentile(s, 99),
+            s->count ? s->samples[s->count - 1] : 0.0);
+}
+
+static void print_usage(const char* program) {
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  --components N   number of .tsx components (default 500)\n"
+        "  --depth N        directory nesting below ./src (default 3)\n"
+        "  --elements N     elements per component (default 20)\n"
+        "  --classes N      classes per element (default 4)\n"
+        "  --vocab N        distinct class names (default 2000)\n"
+        "  --rules N        static rules in styles.toml (default 1000)\n"
+        "  --edits N        warm single-file edits (default 50)\n"
+        "  --bursts N       branch-switch bursts (default 5)\n"
+        "  --burst-pct N    share of files touched per burst (default 20)\n"
+        "  --seed N         random seed (default 42)\n"
+        "  --workdir DIR    scratch directory, wiped first if it is empty or was\n"
+        "                   created by dx_bench (default bench_workspace)\n"
+        "  --generator BIN  styles_generator binary (default ./styles_generator)\n"
+        "  --out FILE       JSON results (default bench_results.json)\n",
+        program);
+}
+
+static int parse_args(int argc, char* argv[], BenchConfig* cfg) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (i + 1 >= argc) return -1;
+        const char* value = argv[++i];
+        if (strcmp(arg, "--components") == 0) cfg->components = atoi(value);
+        else if (strcmp(arg, "--depth") == 0) cfg->depth = atoi(value);
+        else if (strcmp(arg, "--elements") == 0) cfg->elements = atoi(value);
+        else if (strcmp(arg, "--classes") == 0) cfg->classes_per_element = atoi(value);
+        else if (strcmp(arg, "--vocab") == 0) cfg->vocabulary = atoi(value);
+        else if (strcmp(arg, "--rules") == 0) cfg->rules = atoi(value);
+        else if (strcmp(arg, "--edits") == 0) cfg->edits = atoi(value);
+        else if (strcmp(arg, "--bursts") == 0) cfg->bursts = atoi(value);
+        else if (strcmp(arg, "--burst-pct") == 0) cfg->burst_percent = atoi(value);
+        else if (strcmp(arg, "--seed") == 0) cfg->seed = (unsigned int)strtoul(value, NULL, 10);
+        else if (strcmp(arg, "--workdir") == 0) cfg->workdir = value;
+        else if (strcmp(arg, "--generator") == 0) cfg->generator = value;
+        else if (strcmp(arg, "--out") == 0) cfg->output = value;
+        else return -1;
+    }
+    if (cfg->components <= 0 || cfg->depth < 0 || cfg->elements <= 0 || cfg->classes_per_element <= 0 ||
+        cfg->vocabulary <= 0 || cfg->rules < 0 || cfg->edits < 0 || cfg->bursts < 0 ||
+        cfg->burst_percent <= 0 || cfg->burst_percent > 100) {
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig cfg = {
+        .components = 500, .depth = 3, .elements = 20, .classes_per_element = 4,
+        .vocabulary = 2000, .rules = 1000, .edits = 50, .bursts = 5, .burst_percent = 20,
+        .seed = 42, .workdir = "bench_workspace", .generator = "./styles_generator",
+        .output = "bench_results.json",
+    };
+    if (parse_args(argc, argv, &cfg) != 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    char generator[PATH_MAX], output[PATH_MAX];
+    if (!realpath(cfg.generator, generator)) {
+        fprintf(stderr, "%sCannot find styles_generator at '%s'%s\n", KRED, cfg.generator, KNRM);
+        return 1;
+    }
+    cfg.generator = generator;
+    if (cfg.output[0] != '/') {
+        CHECK(getcwd(output, sizeof(output)));
+        strncat(output, "/", sizeof(output) - strlen(output) - 1);
+        strncat(output, cfg.output, sizeof(output) - strlen(output) - 1);
+        cfg.output = output;
+    }
+
+    if (prepare_workdir(cfg.workdir) != 0) return 1;
+    mkdir("./src", 0755);
+    srand(cfg.seed);
+
+    uint64_t start = uv_hrtime();
+    synthesize_tree(&cfg);
+    double synthesize_ms = elapsed_ms(start);
+    double generator_ms = run_generator(&cfg);
+
+    start = uv_hrtime();
+    run_modification_cycle(NULL);
+    double cold_ms = elapsed_ms(start);
+
+    start = uv_hrtime();
+    run_modification_cycle(NULL);
+    double settled_ms = elapsed_ms(start);
+
+    Samples edits = {0}, bursts = {0};
+    measure_edits(&cfg, &edits);
+    measure_bursts(&cfg, &bursts);
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    FILE* fp = fopen(cfg.output, "w");
+    CHECK(fp);
+    fprintf(fp, "{\n  \"config\": {\"components\": %d, \"depth\": %d, \"elements\": %d, \"classes_per_element\": %d, "
+                "\"vocabulary\": %d, \"rules\": %d, \"edits\": %d, \"bursts\": %d, \"burst_percent\": %d, \"seed\": %u},\n",
+            cfg.components, cfg.depth, cfg.elements, cfg.classes_per_element, cfg.vocabulary, cfg.rules,
+            cfg.edits, cfg.bursts, cfg.burst_percent, cfg.seed);
+    fprintf(fp, "  \"synthesize_ms\": %.3f,\n  \"generator_ms\": %.3f,\n  \"cold_cycle_ms\": %.3f,\n  \"settled_cycle_ms\": %.3f,\n",
+            synthesize_ms, generator_ms, cold_ms, settled_ms);
+    write_samples_json(fp, "warm_edit_ms", &edits);
+    write_samples_json(fp, "burst_ms", &bursts);
+    fprintf(fp, "  \"peak_rss_kb\": %ld\n}\n", usage.ru_maxrss);
+    fclose(fp);
+
+    fprintf(stderr, "cold %.2fms, warm edit p50 %.2fms p99 %.2fms, burst p50 %.2fms, peak rss %ld KB -> %s\n",
+            cold_ms, percentile(&edits, 50), percentile(&edits, 99), percentile(&bursts, 50),
+            usage.ru_maxrss, cfg.output);
+
+    for (int i = 0; i < cfg.components; i++) free(component_paths[i]);
+    free(component_paths);
+    free(edits.samples);
+    free(bursts.samples);
+    return 0;
+}
\ No newline at end of file
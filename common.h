@@ -44,11 +44,12 @@ typedef struct UsedIdNode {
     struct UsedIdNode* next;
 } UsedIdNode;
 
+// Names are interned (see intern.h): lists own only their pointer arrays.
 typedef struct {
-    char** class_names;
+    const char** class_names;
     size_t class_count;
     size_t class_capacity;
-    char** injected_ids;
+    const char** injected_ids;
     size_t id_count;
     size_t id_capacity;
 } DataLists;
@@ -59,4 +60,15 @@ typedef struct {
     size_t capacity;
 } FileList;
 
+typedef struct {
+    char* path;
+    DataLists data;
+} FileIndexEntry;
+
+typedef struct {
+    FileIndexEntry* entries;
+    size_t count;
+    size_t capacity;
+} FileIndex;
+
 #endif
\ No newline at end of file
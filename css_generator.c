@@ -1,43 +1,75 @@
 #include "css_generator.h"
 #include "file_io.h"
 #include "utils.h"
+#include "trace.h"
+#include "name_index.h"
 
-void write_final_css(const char* filename, DataLists* data, void* styles_buffer) {
-    StringBuilder sb;
-    sb_init(&sb, 8192);
+// Resolves a class through the perfect hash stored by styles_generator, or
+// by scanning when the buffer predates it.
+static StaticRule_table_t find_rule(StaticRule_vec_t static_rules, flatbuffers_uint32_vec_t index, const char* name) {
+    size_t rule_count = StaticRule_vec_len(static_rules);
+    size_t index_len = flatbuffers_uint32_vec_len(index);
+    if (rule_count > 0 && index_len > 0) {
+        uint32_t bucket_count = flatbuffers_uint32_vec_at(index, 0);
+        if (bucket_count > 0 && index_len == 1 + (size_t)bucket_count + rule_count) {
+            NameHash k = name_index_hash(name, bucket_count, (uint32_t)rule_count);
+            uint32_t slot = name_index_slot(k, flatbuffers_uint32_vec_at(index, 1 + k.bucket), (uint32_t)rule_count);
+            uint32_t pos = flatbuffers_uint32_vec_at(index, 1 + bucket_count + slot);
+            if (pos >= rule_count) return NULL;
+            StaticRule_table_t rule = StaticRule_vec_at(static_rules, pos);
+            return strcmp(name, StaticRule_name(rule)) == 0 ? rule : NULL;
+        }
+    }
+    for (size_t j = 0; j < rule_count; j++) {
+        StaticRule_table_t rule = StaticRule_vec_at(static_rules, j);
+        if (strcmp(name, StaticRule_name(rule)) == 0) return rule;
+    }
+    return NULL;
+}
+
+void generate_css(StringBuilder* sb, const DataLists* data, const void* styles_buffer) {
     char temp_buffer[1024];
     
     Styles_table_t styles = Styles_as_root(styles_buffer);
     StaticRule_vec_t static_rules = Styles_static_rules(styles);
+    flatbuffers_uint32_vec_t name_index = Styles_name_index(styles);
 
     for (size_t i = 0; i < data->class_count; i++) {
         const char* current_class = data->class_names[i];
-        for (size_t j = 0; j < StaticRule_vec_len(static_rules); j++) {
-            StaticRule_table_t rule = StaticRule_vec_at(static_rules, j);
-            if (strcmp(current_class, StaticRule_name(rule)) == 0) {
-                snprintf(temp_buffer, sizeof(temp_buffer), ".%s {\n", current_class);
-                sb_append_str(&sb, temp_buffer);
-                Property_vec_t props = StaticRule_properties(rule);
-                for(size_t k = 0; k < Property_vec_len(props); k++) {
-                    Property_table_t p = Property_vec_at(props, k);
-                    snprintf(temp_buffer, sizeof(temp_buffer), "    %s: %s;\n", Property_key(p), Property_value(p));
-                    sb_append_str(&sb, temp_buffer);
-                }
-                sb_append_str(&sb, "}\n\n");
-                break;
-            }
+        StaticRule_table_t rule = find_rule(static_rules, name_index, current_class);
+        if (!rule) continue;
+        snprintf(temp_buffer, sizeof(temp_buffer), ".%s {\n", current_class);
+        sb_append_str(sb, temp_buffer);
+        Property_vec_t props = StaticRule_properties(rule);
+        for(size_t k = 0; k < Property_vec_len(props); k++) {
+            Property_table_t p = Property_vec_at(props, k);
+            snprintf(temp_buffer, sizeof(temp_buffer), "    %s: %s;\n", Property_key(p), Property_value(p));
+            sb_append_str(sb, temp_buffer);
         }
+        sb_append_str(sb, "}\n\n");
     }
 
     for (size_t i = 0; i < data->id_count; i++) {
         snprintf(temp_buffer, sizeof(temp_buffer), "#%s {}\n\n", data->injected_ids[i]);
-        sb_append_str(&sb, temp_buffer);
+        sb_append_str(sb, temp_buffer);
     }
 
-    if (sb.len > 1) { 
-        sb.buffer[sb.len - 2] = '\0';
-        sb.len -= 2;
+    if (sb->len > 1) { 
+        sb->buffer[sb->len - 2] = '\0';
+        sb->len -= 2;
     }
-    write_file_fast(filename, sb.buffer, sb.len);
+}
+
+void write_final_css(const char* filename, DataLists* data, void* styles_buffer) {
+    StringBuilder sb;
+    sb_init(&sb, 8192);
+
+    uint64_t span = trace_begin();
+    generate_css(&sb, data, styles_buffer);
+    trace_end(TRACE_CSS_EMIT, span, 0, sb.len);
+
+    span = trace_begin();
+    bool written = write_output_file(filename, sb.buffer, sb.len) == DIFF_WRITE_WRITTEN;
+    trace_end(TRACE_WRITE, span, written ? 1 : 0, written ? sb.len : 0);
     sb_free(&sb);
 }
\ No newline at end of file
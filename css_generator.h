@@ -3,6 +3,7 @@
 
 #include "common.h"
 
+void generate_css(StringBuilder* sb, const DataLists* data, const void* styles_buffer);
 void write_final_css(const char* filename, DataLists* data, void* styles_buffer);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,151 @@
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "diff_writer.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// pread rather than a mapping: a file that shrinks while it is compared
+// reads short instead of raising SIGBUS.
+#define DIFF_READ_CHUNK (16 * 1024)
+
+static int contents_match(int fd, const char* content, size_t len) {
+    char buffer[DIFF_READ_CHUNK];
+    for (size_t offset = 0; offset < len;) {
+        size_t want = len - offset < sizeof(buffer) ? len - offset : sizeof(buffer);
+        ssize_t got = pread(fd, buffer, want, (off_t)offset);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0 || memcmp(buffer, content + offset, (size_t)got) != 0) return 0;
+        offset += (size_t)got;
+    }
+    return 1;
+}
+
+static int write_all(int fd, const char* content, size_t len) {
+    for (size_t offset = 0; offset < len;) {
+        ssize_t put = pwrite(fd, content + offset, len - offset, (off_t)offset);
+        if (put < 0 && errno == EINTR) continue;
+        if (put <= 0) return -1;
+        offset += (size_t)put;
+    }
+    return 0;
+}
+
+// The new contents go to a sibling that is renamed over `name`, so a reader
+// sees either the old file or the new one, never a mix. An existing file's
+// permissions carry over; `mode` is -1 for a new file.
+static int write_replacing(int dir_fd, const char* name, const char* content, size_t len, int mode) {
+    char tmp[PATH_MAX];
+    if (snprintf(tmp, sizeof(tmp), "%s.%ld.dx-tmp", name, (long)getpid()) >= (int)sizeof(tmp)) return -1;
+    int fd = openat(dir_fd, tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return -1;
+    int rc = write_all(fd, content, len);
+    if (rc == 0 && mode >= 0) rc = fchmod(fd, (mode_t)mode);
+    if (close(fd) != 0) rc = -1;
+    if (rc == 0) rc = renameat(dir_fd, tmp, dir_fd, name);
+    if (rc != 0) unlinkat(dir_fd, tmp, 0);
+    return rc;
+}
+
+// A symlinked output is rewritten through the link so the link survives;
+// readers of it can see a partial write.
+static int write_in_place(int dir_fd, const char* name, const char* content, size_t len) {
+    int fd = openat(dir_fd, name, O_WRONLY | O_TRUNC | O_CLOEXEC);
+    if (fd < 0) return -1;
+    int rc = write_all(fd, content, len);
+    if (close(fd) != 0) rc = -1;
+    return rc;
+}
+
+DiffWriteResult diff_write_file_at(int dir_fd, const char* name, const char* content, size_t len,
+                                   DiffWriteStats* stats) {
+    DiffWriteStats ignored;
+    if (!stats) stats = &ignored;
+
+    int fd = openat(dir_fd, name, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    int mode = -1;
+    if (fd >= 0) {
+        int same = 0;
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+            mode = (int)(st.st_mode & 07777);
+            if ((size_t)st.st_size == len) {
+                stats->bytes_compared += len;
+                same = contents_match(fd, content, len);
+            }
+        }
+        close(fd);
+        if (same) {
+            stats->skipped++;
+            return DIFF_WRITE_SKIPPED;
+        }
+    }
+
+    int rc = fstatat(dir_fd, name, &st, AT_SYMLINK_NOFOLLOW) == 0 && S_ISLNK(st.st_mode)
+                 ? write_in_place(dir_fd, name, content, len)
+                 : write_replacing(dir_fd, name, content, len, mode);
+    if (rc != 0) {
+        stats->failed++;
+        return DIFF_WRITE_FAILED;
+    }
+    stats->written++;
+    stats->bytes_written += len;
+    return DIFF_WRITE_WRITTEN;
+}
+
+DiffWriteResult diff_write_file(const char* path, const char* content, size_t len, DiffWriteStats* stats) {
+    return diff_write_file_at(AT_FDCWD, path, content, len, stats);
+}
+
+#else
+
+static int contents_match(FILE* fp, const char* content, size_t len, DiffWriteStats* stats) {
+    if (fseek(fp, 0, SEEK_END) != 0 || ftell(fp) != (long)len) return 0;
+    rewind(fp);
+    stats->bytes_compared += len;
+    char buffer[16 * 1024];
+    for (size_t offset = 0; offset < len;) {
+        size_t got = fread(buffer, 1, sizeof(buffer), fp);
+        if (got == 0 || offset + got > len || memcmp(buffer, content + offset, got) != 0) return 0;
+        offset += got;
+    }
+    return 1;
+}
+
+DiffWriteResult diff_write_file(const char* path, const char* content, size_t len, DiffWriteStats* stats) {
+    DiffWriteStats ignored;
+    if (!stats) stats = &ignored;
+
+    FILE* fp = fopen(path, "rb");
+    if (fp) {
+        int same = contents_match(fp, content, len, stats);
+        fclose(fp);
+        if (same) {
+            stats->skipped++;
+            return DIFF_WRITE_SKIPPED;
+        }
+    }
+
+    fp = fopen(path, "wb");
+    int ok = fp != NULL;
+    if (ok && len > 0 && fwrite(content, 1, len, fp) != len) ok = 0;
+    if (fp && fclose(fp) != 0) ok = 0;
+    if (!ok) {
+        stats->failed++;
+        return DIFF_WRITE_FAILED;
+    }
+    stats->written++;
+    stats->bytes_written += len;
+    return DIFF_WRITE_WRITTEN;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,33 @@
+#ifndef DX_DIFF_WRITER_H
+#define DX_DIFF_WRITER_H
+
+#include <stddef.h>
+
+// Writes generated files only when their bytes change: the existing file is
+// compared first (size, then contents) and left alone when it already holds
+// `content`, so its mtime stays put and make/bundler caches keyed on it stay
+// warm. Changed files are replaced through a rename, so readers never see
+// a half-written one. Needs nothing beyond libc so the file generator in src/ can link it
+// without libuv.
+typedef enum {
+    DIFF_WRITE_FAILED = -1,
+    DIFF_WRITE_SKIPPED = 0,
+    DIFF_WRITE_WRITTEN = 1
+} DiffWriteResult;
+
+typedef struct {
+    size_t written;
+    size_t skipped;
+    size_t failed;
+    size_t bytes_written;
+    size_t bytes_compared;
+} DiffWriteStats;
+
+// `stats` may be NULL. It is not synchronised; give each thread its own.
+DiffWriteResult diff_write_file(const char* path, const char* content, size_t len, DiffWriteStats* stats);
+#if defined(__unix__) || defined(__APPLE__)
+DiffWriteResult diff_write_file_at(int dir_fd, const char* name, const char* content, size_t len,
+                                   DiffWriteStats* stats);
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,459 @@
+// d_type and open_by_handle_at() are hidden by -D_POSIX_C_SOURCE.
+#define _GNU_SOURCE
+#include "dir_watch.h"
+
+static dir_watch_cb callback = NULL;
+static DirWatchBackend preferred_backend = DIR_WATCH_INOTIFY;
+
+void dir_watch_set_backend(DirWatchBackend backend) {
+    preferred_backend = backend;
+}
+
+#ifdef __linux__
+
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
+#include <sys/inotify.h>
+#include <sys/fanotify.h>
+
+#define WATCH_MASK (IN_ATTRIB | IN_CREATE | IN_MODIFY | IN_CLOSE_WRITE | IN_DELETE | IN_DELETE_SELF | \
+                    IN_MOVE_SELF | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR)
+
+typedef struct {
+    char** items;
+    size_t count;
+    size_t capacity;
+} PathList;
+
+// Either an inotify or a fanotify descriptor, polled by the loop.
+static int notify_fd = -1;
+static bool using_fanotify = false;
+static char* watch_root = NULL;
+static uv_poll_t poll_handle;
+// Directory of every live watch, indexed by watch descriptor; the kernel
+// hands these out sequentially per inotify instance.
+static char** watched = NULL;
+static size_t watched_capacity = 0;
+static size_t watch_count = 0;
+// Directories left unwatched after max_user_watches ran out.
+static PathList pending = {0};
+static bool limit_reported = false;
+
+static void path_list_push(PathList* list, char* path) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 64;
+        list->items = realloc(list->items, list->capacity * sizeof(char*));
+        CHECK(list->items);
+    }
+    list->items[list->count++] = path;
+}
+
+static bool is_skipped(const char* name) {
+    return name[0] == '.' || strcmp(name, "node_modules") == 0;
+}
+
+static bool add_watch(const char* dir) {
+    int wd = inotify_add_watch(notify_fd, dir, WATCH_MASK);
+    if (wd < 0) {
+        if (errno == ENOSPC) {
+            if (!limit_reported) {
+                fprintf(stderr, "%sinotify watch limit reached after %zu directories; '%s' and any further directories are "
+                        "not watched until watches free up (raise fs.inotify.max_user_watches)%s\n",
+                        KRED, watch_count, dir, KNRM);
+                limit_reported = true;
+            }
+            char* copy = strdup(dir);
+            CHECK(copy);
+            path_list_push(&pending, copy);
+        } else if (errno != ENOENT && errno != ENOTDIR) {
+            fprintf(stderr, "Could not watch '%s': %s\n", dir, strerror(errno));
+        }
+        return false;
+    }
+
+    if ((size_t)wd >= watched_capacity) {
+        size_t capacity = watched_capacity ? watched_capacity : 256;
+        while (capacity <= (size_t)wd) capacity *= 2;
+        watched = realloc(watched, capacity * sizeof(char*));
+        CHECK(watched);
+        memset(watched + watched_capacity, 0, (capacity - watched_capacity) * sizeof(char*));
+        watched_capacity = capacity;
+    }
+    if (watched[wd]) {
+        free(watched[wd]);
+    } else {
+        watch_count++;
+    }
+    watched[wd] = strdup(dir);
+    CHECK(watched[wd]);
+    return true;
+}
+
+// Watches `root` and every directory below it. Each directory is watched
+// before it is listed, so entries created meanwhile are either listed or
+// reported by the new watch; `report_files` passes listed files on as
+// changes for directories that appeared after startup. Under fanotify the
+// filesystem mark already covers the tree and only the listing is needed.
+static void add_tree(const char* root, bool report_files) {
+    PathList stack = {0};
+    char* first = strdup(root);
+    CHECK(first);
+    path_list_push(&stack, first);
+
+    while (stack.count > 0) {
+        char* dir = stack.items[--stack.count];
+        DIR* d = using_fanotify || add_watch(dir) ? opendir(dir) : NULL;
+        struct dirent* entry;
+        while (d && (entry = readdir(d))) {
+            if (is_skipped(entry->d_name)) continue;
+            char path[PATH_MAX];
+            if (snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name) >= (int)sizeof(path)) continue;
+
+            bool is_dir = entry->d_type == DT_DIR;
+            if (entry->d_type == DT_UNKNOWN) {
+                struct stat st;
+                is_dir = stat(path, &st) == 0 && S_ISDIR(st.st_mode);
+            }
+            if (is_dir) {
+                char* copy = strdup(path);
+                CHECK(copy);
+                path_list_push(&stack, copy);
+            } else if (report_files) {
+                callback(path, DIR_WATCH_WRITTEN);
+            }
+        }
+        if (d) closedir(d);
+        free(dir);
+    }
+    free(stack.items);
+}
+
+static bool is_within(const char* path, const char* dir, size_t dir_len) {
+    return strncmp(path, dir, dir_len) == 0 && (path[dir_len] == '\0' || path[dir_len] == '/');
+}
+
+// A directory moved away keeps its watches under a stale path; drop them
+// and let the IN_MOVED_TO side (if it stays inside the tree) re-add it.
+static void drop_tree(const char* dir) {
+    size_t dir_len = strlen(dir);
+    for (size_t wd = 0; wd < watched_capacity; wd++) {
+        if (watched[wd] && is_within(watched[wd], dir, dir_len)) inotify_rm_watch(notify_fd, (int)wd);
+    }
+    size_t kept = 0;
+    for (size_t i = 0; i < pending.count; i++) {
+        if (is_within(pending.items[i], dir, dir_len)) free(pending.items[i]);
+        else pending.items[kept++] = pending.items[i];
+    }
+    pending.count = kept;
+}
+
+static void retry_pending(void) {
+    PathList retry = pending;
+    pending = (PathList){0};
+    limit_reported = false;
+    for (size_t i = 0; i < retry.count; i++) {
+        add_tree(retry.items[i], true);
+        free(retry.items[i]);
+    }
+    free(retry.items);
+}
+
+// Dropped events may include directories created or moved in, so the tree
+// is walked again and the whole of it is reported as changed. Directories
+// already watched keep their watch descriptor. Dropping the watches first
+// would queue an IN_IGNORED per directory and overflow the queue again.
+static void rewatch_after_overflow(void) {
+    fprintf(stderr, "%sinotify queue overflowed; rescanning '%s'%s\n", KRED, watch_root, KNRM);
+    add_tree(watch_root, false);
+    callback(watch_root, DIR_WATCH_CREATED | DIR_WATCH_ISDIR);
+}
+
+static void handle_event(const struct inotify_event* ev) {
+    if (ev->mask & IN_Q_OVERFLOW) {
+        rewatch_after_overflow();
+        return;
+    }
+    if (ev->wd < 0 || (size_t)ev->wd >= watched_capacity || !watched[ev->wd]) return;
+
+    if (ev->mask & IN_IGNORED) {
+        free(watched[ev->wd]);
+        watched[ev->wd] = NULL;
+        watch_count--;
+        if (pending.count > 0) retry_pending();
+        return;
+    }
+    if (ev->len == 0) return;
+
+    char path[PATH_MAX];
+    if (snprintf(path, sizeof(path), "%s/%s", watched[ev->wd], ev->name) >= (int)sizeof(path)) return;
+
+    if (ev->mask & IN_ISDIR) {
+        if (is_skipped(ev->name)) return;
+        if (ev->mask & (IN_CREATE | IN_MOVED_TO)) {
+            add_tree(path, true);
+            callback(path, DIR_WATCH_CREATED | DIR_WATCH_ISDIR);
+        } else {
+            if (ev->mask & IN_MOVED_FROM) drop_tree(path);
+            callback(path, DIR_WATCH_REMOVED | DIR_WATCH_ISDIR);
+        }
+        return;
+    }
+
+    int events = 0;
+    if (ev->mask & (IN_ATTRIB | IN_MODIFY)) events |= DIR_WATCH_CHANGED;
+    if (ev->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) events |= DIR_WATCH_WRITTEN;
+    if (ev->mask & (IN_CREATE | IN_MOVED_TO)) events |= DIR_WATCH_CREATED;
+    if (ev->mask & (IN_DELETE | IN_MOVED_FROM)) events |= DIR_WATCH_REMOVED;
+    if (events) callback(path, events);
+}
+
+static void on_inotify_readable(uv_poll_t *handle, int status, int events) {
+    (void)handle;
+    (void)events;
+    if (status < 0) {
+        fprintf(stderr, "Error watching files: %s\n", uv_strerror(status));
+        return;
+    }
+
+    char buf[64 * 1024] __attribute__((aligned(__alignof__(struct inotify_event))));
+    ssize_t n;
+    while ((n = read(notify_fd, buf, sizeof(buf))) > 0) {
+        for (char* p = buf; p < buf + n; ) {
+            const struct inotify_event* ev = (const struct inotify_event*)p;
+            p += sizeof(struct inotify_event) + ev->len;
+            handle_event(ev);
+        }
+    }
+}
+
+// fanotify reports the changed entry as a handle of its parent directory
+// plus a name. Resolving a handle costs open_by_handle_at() and a readlink,
+// so resolved directories are cached until a directory is moved or removed.
+#define DIR_CACHE_SIZE 1024
+
+typedef struct {
+    uint64_t hash;
+    unsigned char handle[sizeof(struct file_handle) + MAX_HANDLE_SZ];
+    size_t handle_len;
+    char* path;
+} DirCacheEntry;
+
+static int mount_fd = -1;
+static char* real_root = NULL;
+static size_t real_root_len = 0;
+static DirCacheEntry dir_cache[DIR_CACHE_SIZE];
+
+static void dir_cache_clear(void) {
+    for (size_t i = 0; i < DIR_CACHE_SIZE; i++) {
+        free(dir_cache[i].path);
+        dir_cache[i].path = NULL;
+    }
+}
+
+static const char* resolve_dir(struct file_handle* fh) {
+    size_t handle_len = sizeof(struct file_handle) + fh->handle_bytes;
+    if (fh->handle_bytes > MAX_HANDLE_SZ) return NULL;
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < handle_len; i++) {
+        hash ^= ((const unsigned char*)fh)[i];
+        hash *= 1099511628211ULL;
+    }
+    DirCacheEntry* entry = &dir_cache[hash % DIR_CACHE_SIZE];
+    if (entry->path && entry->hash == hash && entry->handle_len == handle_len &&
+        memcmp(entry->handle, fh, handle_len) == 0) return entry->path;
+
+    int dir_fd = open_by_handle_at(mount_fd, fh, O_PATH);
+    if (dir_fd < 0) return NULL;
+    char link[64], path[PATH_MAX];
+    snprintf(link, sizeof(link), "/proc/self/fd/%d", dir_fd);
+    ssize_t len = readlink(link, path, sizeof(path) - 1);
+    close(dir_fd);
+    if (len < 0) return NULL;
+    path[len] = '\0';
+
+    free(entry->path);
+    entry->path = strdup(path);
+    CHECK(entry->path);
+    entry->hash = hash;
+    entry->handle_len = handle_len;
+    memcpy(entry->handle, fh, handle_len);
+    return entry->path;
+}
+
+static void handle_fanotify_event(const struct fanotify_event_metadata* md) {
+    const struct fanotify_event_info_fid* fid = (const struct fanotify_event_info_fid*)(md + 1);
+    if (md->event_len < sizeof(*md) + sizeof(*fid) || fid->hdr.info_type != FAN_EVENT_INFO_TYPE_DFID_NAME) return;
+    struct file_handle* fh = (struct file_handle*)fid->handle;
+    const char* name = (const char*)fh->f_handle + fh->handle_bytes;
+
+    if ((md->mask & FAN_ONDIR) && (md->mask & (FAN_MOVED_FROM | FAN_MOVED_TO | FAN_DELETE))) dir_cache_clear();
+    if (strcmp(name, ".") == 0) return;
+
+    const char* dir = resolve_dir(fh);
+    if (!dir || strncmp(dir, real_root, real_root_len) != 0 ||
+        (dir[real_root_len] != '\0' && dir[real_root_len] != '/')) return;
+
+    // Report the path in the form the caller passed the root in.
+    char path[PATH_MAX];
+    if (snprintf(path, sizeof(path), "%s%s/%s", watch_root, dir + real_root_len, name) >= (int)sizeof(path)) return;
+    for (const char* p = dir + real_root_len; *p; p++) {
+        if (p[0] == '/' && is_skipped(p + 1)) return;
+    }
+    if (is_skipped(name)) return;
+
+    int events = 0;
+    if (md->mask & (FAN_MODIFY | FAN_ATTRIB)) events |= DIR_WATCH_CHANGED;
+    if (md->mask & (FAN_CLOSE_WRITE | FAN_MOVED_TO)) events |= DIR_WATCH_WRITTEN;
+    if (md->mask & (FAN_CREATE | FAN_MOVED_TO)) events |= DIR_WATCH_CREATED;
+    if (md->mask & (FAN_DELETE | FAN_MOVED_FROM)) events |= DIR_WATCH_REMOVED;
+    if (md->mask & FAN_ONDIR) {
+        events &= DIR_WATCH_CREATED | DIR_WATCH_REMOVED;
+        if (!events) return;
+        if (events & DIR_WATCH_CREATED) add_tree(path, true);
+        events |= DIR_WATCH_ISDIR;
+    }
+    if (events) callback(path, events);
+}
+
+static void on_fanotify_readable(uv_poll_t *handle, int status, int events) {
+    (void)handle;
+    (void)events;
+    if (status < 0) {
+        fprintf(stderr, "Error watching files: %s\n", uv_strerror(status));
+        return;
+    }
+
+    char buf[64 * 1024] __attribute__((aligned(__alignof__(struct fanotify_event_metadata))));
+    ssize_t n;
+    while ((n = read(notify_fd, buf, sizeof(buf))) > 0) {
+        const struct fanotify_event_metadata* md = (const struct fanotify_event_metadata*)buf;
+        for (; FAN_EVENT_OK(md, n); md = FAN_EVENT_NEXT(md, n)) {
+            if (md->mask & FAN_Q_OVERFLOW) {
+                fprintf(stderr, "%sfanotify queue overflowed; rescanning '%s'%s\n", KRED, watch_root, KNRM);
+                dir_cache_clear();
+                callback(watch_root, DIR_WATCH_CREATED | DIR_WATCH_ISDIR);
+                continue;
+            }
+            handle_fanotify_event(md);
+        }
+    }
+}
+
+static int fanotify_start(const char* root) {
+    int fd = fanotify_init(FAN_CLASS_NOTIF | FAN_REPORT_DFID_NAME | FAN_NONBLOCK | FAN_CLOEXEC, O_RDONLY);
+    if (fd < 0) return -errno;
+    uint64_t mask = FAN_MODIFY | FAN_ATTRIB | FAN_CLOSE_WRITE | FAN_CREATE | FAN_DELETE | FAN_MOVED_FROM | FAN_MOVED_TO | FAN_ONDIR;
+    char* resolved = realpath(root, NULL);
+    int dir_fd = open(root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (!resolved || dir_fd < 0 || fanotify_mark(fd, FAN_MARK_ADD | FAN_MARK_FILESYSTEM, mask, AT_FDCWD, root) != 0) {
+        int err = -errno;
+        free(resolved);
+        if (dir_fd >= 0) close(dir_fd);
+        close(fd);
+        return err;
+    }
+
+    notify_fd = fd;
+    mount_fd = dir_fd;
+    using_fanotify = true;
+    real_root = resolved;
+    real_root_len = strlen(resolved);
+    if (real_root_len == 1) real_root_len = 0;
+    watch_root = strdup(root);
+    CHECK(watch_root);
+    return 0;
+}
+
+static int inotify_start(const char* root) {
+    notify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (notify_fd < 0) return -errno;
+    watch_root = strdup(root);
+    CHECK(watch_root);
+    add_tree(root, false);
+    return 0;
+}
+
+int dir_watch_start(uv_loop_t *loop, const char* root, dir_watch_cb cb) {
+    callback = cb;
+    int r = -1;
+    if (preferred_backend == DIR_WATCH_FANOTIFY) {
+        r = fanotify_start(root);
+        if (r != 0) {
+            fprintf(stderr, "%sfanotify is not available (%s); watching with inotify%s\n", KRED, uv_strerror(r), KNRM);
+        }
+    }
+    if (r != 0 && (r = inotify_start(root)) != 0) return r;
+
+    r = uv_poll_init(loop, &poll_handle, notify_fd);
+    if (r == 0) r = uv_poll_start(&poll_handle, UV_READABLE, using_fanotify ? on_fanotify_readable : on_inotify_readable);
+    return r;
+}
+
+static void on_poll_closed(uv_handle_t *handle) {
+    (void)handle;
+    close(notify_fd);
+    notify_fd = -1;
+    if (mount_fd >= 0) close(mount_fd);
+    mount_fd = -1;
+}
+
+void dir_watch_stop(void) {
+    if (notify_fd < 0) return;
+    uv_close((uv_handle_t*)&poll_handle, on_poll_closed);
+
+    for (size_t wd = 0; wd < watched_capacity; wd++) free(watched[wd]);
+    free(watched);
+    watched = NULL;
+    watched_capacity = 0;
+    watch_count = 0;
+    for (size_t i = 0; i < pending.count; i++) free(pending.items[i]);
+    free(pending.items);
+    pending = (PathList){0};
+
+    dir_cache_clear();
+    free(watch_root);
+    free(real_root);
+    watch_root = real_root = NULL;
+    using_fanotify = false;
+}
+
+#else
+
+static uv_fs_event_t fs_event;
+static char* watch_root = NULL;
+
+static void on_fs_event(uv_fs_event_t *handle, const char *filename, int events, int status) {
+    (void)handle;
+    if (status < 0) {
+        fprintf(stderr, "Error watching file: %s\n", uv_strerror(status));
+        return;
+    }
+    if (!filename) return;
+
+    // Backends behind uv_fs_event report once a write has landed, so both
+    // kinds count as finished saves.
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/%s", watch_root, filename);
+    int kinds = DIR_WATCH_WRITTEN;
+    if (events & UV_CHANGE) kinds |= DIR_WATCH_CHANGED;
+    if (events & UV_RENAME) kinds |= DIR_WATCH_CREATED | DIR_WATCH_REMOVED;
+    callback(path, kinds);
+}
+
+int dir_watch_start(uv_loop_t *loop, const char* root, dir_watch_cb cb) {
+    callback = cb;
+    watch_root = strdup(root);
+    CHECK(watch_root);
+    uv_fs_event_init(loop, &fs_event);
+    return uv_fs_event_start(&fs_event, on_fs_event, root, UV_FS_EVENT_RECURSIVE);
+}
+
+void dir_watch_stop(void) {
+    if (!watch_root) return;
+    uv_close((uv_handle_t*)&fs_event, NULL);
+    free(watch_root);
+    watch_root = NULL;
+}
+
+#endif
\ No newline at end of file
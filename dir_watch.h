@@ -0,0 +1,47 @@
+#ifndef DX_DIR_WATCH_H
+#define DX_DIR_WATCH_H
+
+#include "common.h"
+
+// Event bits. DIR_WATCH_CHANGED fires for every write, possibly while a save
+// is still in progress; DIR_WATCH_WRITTEN marks a finished one, either the
+// writer closing the file or a complete file renamed into place.
+// CREATED and REMOVED cover entries created, deleted or moved in or out;
+// DIR_WATCH_ISDIR is added when that entry is a directory.
+enum {
+    DIR_WATCH_CHANGED = 1,
+    DIR_WATCH_WRITTEN = 2,
+    DIR_WATCH_CREATED = 4,
+    DIR_WATCH_REMOVED = 8,
+    DIR_WATCH_ISDIR = 16
+};
+
+// Reports changes anywhere below `root`. `path` is `root/<relative path>`,
+// or `root` itself, reported as a created directory, after the kernel's
+// event queue overflowed and any part of the tree may have changed.
+typedef void (*dir_watch_cb)(const char* path, int events);
+
+typedef enum {
+    DIR_WATCH_INOTIFY,
+    DIR_WATCH_FANOTIFY
+} DirWatchBackend;
+
+// On Linux this keeps one inotify watch per directory on a single inotify
+// descriptor polled by the loop, since libuv ignores UV_FS_EVENT_RECURSIVE
+// there. Directories created later are watched before they are scanned, and
+// files found by that scan are reported as written. Once the kernel's
+// max_user_watches is exhausted the remaining directories are reported and
+// retried whenever a watch is released. Elsewhere a recursive uv_fs_event_t
+// is used.
+//
+// DIR_WATCH_FANOTIFY instead marks the whole filesystem holding `root`
+// (FAN_REPORT_DFID_NAME) and filters events by path, so startup does not
+// depend on the number of directories. Directories created or moved in are
+// listed the same way, as the kernel only reports the directory itself. It
+// needs CAP_SYS_ADMIN and Linux 5.9+; when it is refused the inotify tree is
+// used.
+void dir_watch_set_backend(DirWatchBackend backend);
+int dir_watch_start(uv_loop_t *loop, const char* root, dir_watch_cb cb);
+void dir_watch_stop(void);
+
+#endif
\ No newline at end of file
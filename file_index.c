@@ -0,0 +1,100 @@
+#include "file_index.h"
+#include "parser.h"
+#include "utils.h"
+
+// Position of the first entry not ordered before `path`.
+static size_t lower_bound(const FileIndex* index, const char* path) {
+    size_t lo = 0, hi = index->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (strcmp(index->entries[mid].path, path) < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+static FileIndexEntry* find_entry(const FileIndex* index, const char* path) {
+    size_t i = lower_bound(index, path);
+    return i < index->count && strcmp(index->entries[i].path, path) == 0 ? &index->entries[i] : NULL;
+}
+
+// Cycles deliver files in sorted order, so a first scan keeps appending
+// and the memmove only runs for files added later.
+static void store_entry(FileIndex* index, const char* path, DataLists* data) {
+    size_t i = lower_bound(index, path);
+    if (i < index->count && strcmp(index->entries[i].path, path) == 0) {
+        free_data_contents(&index->entries[i].data);
+        index->entries[i].data = *data;
+        return;
+    }
+
+    if (index->count >= index->capacity) {
+        index->capacity = index->capacity == 0 ? 16 : index->capacity * 2;
+        index->entries = realloc(index->entries, index->capacity * sizeof(FileIndexEntry));
+        CHECK(index->entries);
+    }
+    memmove(&index->entries[i + 1], &index->entries[i], (index->count - i) * sizeof(FileIndexEntry));
+    index->count++;
+    FileIndexEntry* entry = &index->entries[i];
+    entry->path = strdup(path);
+    CHECK(entry->path);
+    entry->data = *data;
+}
+
+void file_index_update(FileIndex* index, const char* path) {
+    DataLists data = {0};
+    collect_file_data(&data, path);
+    store_entry(index, path, &data);
+}
+
+void file_index_update_buffer(FileIndex* index, const char* path, const char* source, size_t size) {
+    DataLists data = {0};
+    collect_buffer_data(&data, source, size);
+    store_entry(index, path, &data);
+}
+
+// `files` must be sorted with compare_strings.
+void file_index_retain(FileIndex* index, const FileList* files) {
+    size_t kept = 0;
+    for (size_t i = 0; i < index->count; i++) {
+        const char* path = index->entries[i].path;
+        if (bsearch(&path, files->paths, files->count, sizeof(char*), compare_strings)) {
+            index->entries[kept++] = index->entries[i];
+        } else {
+            free(index->entries[i].path);
+            free_data_contents(&index->entries[i].data);
+        }
+    }
+    index->count = kept;
+}
+
+void file_index_remove(FileIndex* index, const char* path) {
+    FileIndexEntry* entry = find_entry(index, path);
+    if (!entry) return;
+    free(entry->path);
+    free_data_contents(&entry->data);
+    size_t i = (size_t)(entry - index->entries);
+    memmove(entry, entry + 1, (index->count - i - 1) * sizeof(FileIndexEntry));
+    index->count--;
+}
+
+const DataLists* file_index_find(const FileIndex* index, const char* path) {
+    FileIndexEntry* entry = find_entry(index, path);
+    return entry ? &entry->data : NULL;
+}
+
+void file_index_merge(const FileIndex* index, DataLists* out) {
+    memset(out, 0, sizeof(DataLists));
+    for (size_t i = 0; i < index->count; i++) {
+        data_lists_merge(out, &index->entries[i].data);
+    }
+}
+
+void file_index_free(FileIndex* index) {
+    for (size_t i = 0; i < index->count; i++) {
+        free(index->entries[i].path);
+        free_data_contents(&index->entries[i].data);
+    }
+    free(index->entries);
+    memset(index, 0, sizeof(FileIndex));
+}
\ No newline at end of file
@@ -0,0 +1,14 @@
+#ifndef DX_FILE_INDEX_H
+#define DX_FILE_INDEX_H
+
+#include "common.h"
+
+void file_index_update(FileIndex* index, const char* path);
+void file_index_update_buffer(FileIndex* index, const char* path, const char* source, size_t size);
+void file_index_retain(FileIndex* index, const FileList* files);
+void file_index_remove(FileIndex* index, const char* path);
+const DataLists* file_index_find(const FileIndex* index, const char* path);
+void file_index_merge(const FileIndex* index, DataLists* out);
+void file_index_free(FileIndex* index);
+
+#endif
\ No newline at end of file
@@ -1,6 +1,10 @@
 #include "file_io.h"
+#include "trace.h"
+
+static DiffWriteStats output_stats;
 
 void *map_file_read(const char *filename, size_t *size) {
+    uint64_t span = trace_begin();
     FILE *fp = fopen(filename, "rb");
     if (!fp) return NULL;
     fseek(fp, 0, SEEK_END);
@@ -12,6 +16,93 @@ void *map_file_read(const char *filename, size_t *size) {
     fread(buffer, 1, *size, fp);
     ((char*)buffer)[*size] = '\0';
     fclose(fp);
+    trace_end(TRACE_READ, span, 1, *size);
+    return buffer;
+}
+
+// Identifies one version of a file: replacing it changes the inode, and any
+// write or chmod moves ctime, which cannot be set back from user space.
+static int format_identity(const uv_stat_t *st, char *out, size_t cap) {
+    return snprintf(out, cap, "%llu %llu %llu %ld.%09ld %ld.%09ld\n",
+                    (unsigned long long)st->st_dev, (unsigned long long)st->st_ino, (unsigned long long)st->st_size,
+                    st->st_mtim.tv_sec, st->st_mtim.tv_nsec, st->st_ctim.tv_sec, st->st_ctim.tv_nsec);
+}
+
+static int file_identity(uv_file fd, char *out, size_t cap, size_t *size) {
+    uv_fs_t req;
+    int rc = uv_fs_fstat(NULL, &req, fd, NULL);
+    uv_stat_t st = req.statbuf;
+    uv_fs_req_cleanup(&req);
+    if (rc != 0) return -1;
+    if (size) *size = (size_t)st.st_size;
+    return format_identity(&st, out, cap);
+}
+
+int file_path_identity(const char *filename, char *out, size_t cap) {
+    uv_fs_t req;
+    int rc = uv_fs_stat(NULL, &req, filename, NULL);
+    uv_stat_t st = req.statbuf;
+    uv_fs_req_cleanup(&req);
+    return rc == 0 ? format_identity(&st, out, cap) : -1;
+}
+
+static void *read_fd(uv_file fd, size_t size, size_t *filled) {
+    char *buffer = malloc(size + 1);
+    if (!buffer) return NULL;
+    *filled = 0;
+    while (*filled < size) {
+        uv_fs_t req;
+        uv_buf_t buf = uv_buf_init(buffer + *filled, (unsigned int)(size - *filled));
+        int n = uv_fs_read(NULL, &req, fd, &buf, 1, (int64_t)*filled, NULL);
+        uv_fs_req_cleanup(&req);
+        if (n < 0) {
+            free(buffer);
+            return NULL;
+        }
+        if (n == 0) break;
+        *filled += (size_t)n;
+    }
+    buffer[*filled] = '\0';
+    return buffer;
+}
+
+void *load_styles_buffer(const char *filename, size_t *size) {
+    uv_fs_t req;
+    uv_file fd = uv_fs_open(NULL, &req, filename, UV_FS_O_RDONLY, 0, NULL);
+    uv_fs_req_cleanup(&req);
+    if (fd < 0) return NULL;
+
+    uint64_t span = trace_begin();
+    char identity[128], after[128];
+    size_t expected_size = 0;
+    int identity_len = file_identity(fd, identity, sizeof(identity), &expected_size);
+    void *buffer = identity_len > 0 ? read_fd(fd, expected_size, size) : NULL;
+    // A file rewritten while it was read is verified but left unstamped.
+    bool stable = buffer && *size == expected_size &&
+                  file_identity(fd, after, sizeof(after), NULL) == identity_len &&
+                  memcmp(identity, after, (size_t)identity_len) == 0;
+    uv_fs_close(NULL, &req, fd, NULL);
+    uv_fs_req_cleanup(&req);
+    if (!buffer) return NULL;
+    trace_end(TRACE_READ, span, 1, *size);
+
+    char stamp_path[512];
+    snprintf(stamp_path, sizeof(stamp_path), "%s.verified", filename);
+    size_t stamp_size;
+    char *stamp = map_file_read(stamp_path, &stamp_size);
+    bool stamped = stable && stamp && stamp_size == (size_t)identity_len && memcmp(stamp, identity, stamp_size) == 0;
+    free(stamp);
+    if (stamped) return buffer;
+
+    span = trace_begin();
+    int rc = Styles_verify_as_root(buffer, *size);
+    trace_end(TRACE_VERIFY, span, 1, *size);
+    if (rc != flatcc_verify_ok) {
+        fprintf(stderr, "%s%s failed verification: %s%s\n", KRED, filename, flatcc_verify_error_string(rc), KNRM);
+        free(buffer);
+        return NULL;
+    }
+    if (stable) write_file_fast(stamp_path, identity, (size_t)identity_len);
     return buffer;
 }
 
@@ -28,6 +119,44 @@ int write_file_fast(const char *filename, const char *content, size_t content_le
     return 0;
 }
 
+DiffWriteResult write_output_file(const char *filename, const char *content, size_t content_len) {
+    return diff_write_file(filename, content, content_len, &output_stats);
+}
+
+const DiffWriteStats *file_io_output_stats(void) {
+    return &output_stats;
+}
+
+void collect_source_files(FileList* list, const char* directory, const char* extension) {
+    uv_fs_t scan_req;
+    if (uv_fs_scandir(NULL, &scan_req, directory, 0, NULL) < 0) {
+        uv_fs_req_cleanup(&scan_req);
+        return;
+    }
+
+    uv_dirent_t dirent;
+    while (UV_EOF != uv_fs_scandir_next(&scan_req, &dirent)) {
+        char full_path[512];
+        snprintf(full_path, sizeof(full_path), "%s/%s", directory, dirent.name);
+
+        if (dirent.type == UV_DIRENT_DIR) {
+            if (dirent.name[0] != '.' && strcmp(dirent.name, "node_modules") != 0) {
+                collect_source_files(list, full_path, extension);
+            }
+        } else if (dirent.type == UV_DIRENT_FILE && strstr(dirent.name, extension)) {
+            if (list->count >= list->capacity) {
+                list->capacity = list->capacity == 0 ? 16 : list->capacity * 2;
+                list->paths = realloc(list->paths, list->capacity * sizeof(char*));
+                CHECK(list->paths);
+            }
+            list->paths[list->count] = strdup(full_path);
+            CHECK(list->paths[list->count]);
+            list->count++;
+        }
+    }
+    uv_fs_req_cleanup(&scan_req);
+}
+
 void free_file_list(FileList* list) {
     for (size_t i = 0; i < list->count; i++) {
         free(list->paths[i]);
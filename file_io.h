@@ -2,9 +2,24 @@
 #define DX_FILE_IO_H
 
 #include "common.h"
+#include "diff_writer.h"
 
 void *map_file_read(const char *filename, size_t *size);
+// Reads a styles.bin and runs the flatcc verifier over it. A buffer that
+// passes is recorded as `<filename>.verified` (device, inode, size, mtime and
+// ctime), so loading the same file again skips the verifier. Any write to or
+// replacement of styles.bin changes that record; the stamp does not protect
+// against someone able to rewrite the stamp as well.
+void *load_styles_buffer(const char *filename, size_t *size);
+// Writes the line load_styles_buffer stamps for `filename`'s current version;
+// returns its length, or -1 when the file cannot be stat'ed.
+int file_path_identity(const char *filename, char *out, size_t cap);
 int write_file_fast(const char *filename, const char *content, size_t content_len);
+// For generated outputs: skipped when the file already holds `content`, and
+// tallied in file_io_output_stats().
+DiffWriteResult write_output_file(const char *filename, const char *content, size_t content_len);
+const DiffWriteStats *file_io_output_stats(void);
+void collect_source_files(FileList* list, const char* directory, const char* extension);
 void free_file_list(FileList* list);
 
 #endif
\ No newline at end of file
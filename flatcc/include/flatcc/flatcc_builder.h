@@ -451,6 +451,9 @@ struct flatcc_builder {
 
     /* The optional user supplied refmap for cloning DAG's - not shared with nested buffers. */
     flatcc_refmap_t *refmap;
+
+    /* Optional string interning table, see `flatcc_builder_set_string_interning`. */
+    struct flatcc_builder_strtab *strtab;
 };
 
 /**
@@ -1701,6 +1704,28 @@ flatcc_builder_union_ref_t *flatcc_builder_union_vector_push(flatcc_builder_t *B
 flatcc_builder_union_ref_t *flatcc_builder_append_union_vector(flatcc_builder_t *B,
         const flatcc_builder_union_ref_t *urefs, size_t count);
 
+/**
+ * Opt-in string interning. When enabled, `flatcc_builder_create_string`
+ * (and the `_str`, `_strn` variants and generated `create` calls built on
+ * it) return the existing reference when a string with the same content
+ * was already created in the current buffer, so repeated keys and values
+ * are stored once. Strings built with `start_string` / `end_string` are
+ * not interned. Interned references are never shared across nested
+ * buffers.
+ *
+ * The table survives `flatcc_builder_reset` empty and is released by
+ * `flatcc_builder_clear` or by disabling interning. Returns -1 if the
+ * table could not be allocated.
+ */
+int flatcc_builder_set_string_interning(flatcc_builder_t *B, int enable);
+
+/**
+ * Number of `create_string` calls answered from the interning table, and
+ * the number of distinct strings it holds. Both are 0 when disabled.
+ */
+void flatcc_builder_get_string_interning_stats(flatcc_builder_t *B,
+        size_t *hits, size_t *unique);
+
 /**
  * Faster string operation that avoids temporary stack storage. The
  * string is not required to be zero-terminated, but is expected
@@ -18,6 +18,7 @@
 
 #include "flatcc/flatcc_builder.h"
 #include "flatcc/flatcc_emitter.h"
+#include "flatcc/flatcc_alloc.h"
 
 /*
  * `check` is designed to handle incorrect use errors that can be
@@ -393,6 +394,167 @@ void flatcc_builder_flush_vtable_cache(flatcc_builder_t *B)
     B->vb_end = 0;
 }
 
+/*
+ * String interning table: open addressing on a content hash. Entries keep
+ * their own copy of the string in `pool` since emitted data cannot be
+ * read back from the emitter, and the buffer's nest_id so references are
+ * only reused within the buffer that created them.
+ */
+typedef struct strtab_entry {
+    uint32_t hash;
+    uoffset_t nest_id;
+    flatcc_builder_ref_t ref;
+    size_t len;
+    size_t pos;
+} strtab_entry_t;
+
+struct flatcc_builder_strtab {
+    strtab_entry_t *slots;
+    size_t nslots;
+    size_t count;
+    size_t hits;
+    char *pool;
+    size_t pool_len;
+    size_t pool_cap;
+};
+
+#define STRTAB_MIN_SLOTS 256
+
+static uint32_t strtab_hash(const char *s, size_t len)
+{
+    uint32_t h = 2166136261u;
+    size_t i;
+
+    for (i = 0; i < len; ++i) {
+        h ^= (uint8_t)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void strtab_reset(struct flatcc_builder_strtab *T)
+{
+    memset(T->slots, 0, T->nslots * sizeof(strtab_entry_t));
+    T->count = 0;
+    T->hits = 0;
+    T->pool_len = 0;
+}
+
+static void strtab_free(struct flatcc_builder_strtab *T)
+{
+    if (T) {
+        FLATCC_FREE(T->slots);
+        FLATCC_FREE(T->pool);
+        FLATCC_FREE(T);
+    }
+}
+
+static strtab_entry_t *strtab_find(struct flatcc_builder_strtab *T,
+        uint32_t hash, uoffset_t nest_id, const char *s, size_t len)
+{
+    size_t mask = T->nslots - 1;
+    size_t i = hash & mask;
+    strtab_entry_t *e;
+
+    for (;;) {
+        e = &T->slots[i];
+        if (e->ref == 0) {
+            return e;
+        }
+        if (e->hash == hash && e->nest_id == nest_id && e->len == len &&
+                memcmp(T->pool + e->pos, s, len) == 0) {
+            return e;
+        }
+        i = (i + 1) & mask;
+    }
+}
+
+static int strtab_grow(struct flatcc_builder_strtab *T)
+{
+    strtab_entry_t *old = T->slots;
+    size_t old_n = T->nslots, i, mask;
+    size_t n = old_n ? 2 * old_n : STRTAB_MIN_SLOTS;
+
+    T->slots = FLATCC_CALLOC(n, sizeof(strtab_entry_t));
+    if (!T->slots) {
+        T->slots = old;
+        return -1;
+    }
+    T->nslots = n;
+    mask = n - 1;
+    for (i = 0; i < old_n; ++i) {
+        size_t k;
+        if (old[i].ref == 0) {
+            continue;
+        }
+        k = old[i].hash & mask;
+        while (T->slots[k].ref != 0) {
+            k = (k + 1) & mask;
+        }
+        T->slots[k] = old[i];
+    }
+    FLATCC_FREE(old);
+    return 0;
+}
+
+/* Records a new string; failure just means it won't be shared. */
+static void strtab_insert(struct flatcc_builder_strtab *T, strtab_entry_t *e,
+        uint32_t hash, uoffset_t nest_id, const char *s, size_t len,
+        flatcc_builder_ref_t ref)
+{
+    if (T->pool_len + len > T->pool_cap) {
+        size_t cap = T->pool_cap ? T->pool_cap : 4096;
+        char *pool;
+
+        while (cap < T->pool_len + len) {
+            cap *= 2;
+        }
+        pool = FLATCC_REALLOC(T->pool, cap);
+        if (!pool) {
+            return;
+        }
+        T->pool = pool;
+        T->pool_cap = cap;
+    }
+    memcpy(T->pool + T->pool_len, s, len);
+    e->hash = hash;
+    e->nest_id = nest_id;
+    e->ref = ref;
+    e->len = len;
+    e->pos = T->pool_len;
+    T->pool_len += len;
+    /* Keep load at or below 50%. */
+    if (2 * ++T->count > T->nslots) {
+        strtab_grow(T);
+    }
+}
+
+int flatcc_builder_set_string_interning(flatcc_builder_t *B, int enable)
+{
+    if (!enable) {
+        strtab_free(B->strtab);
+        B->strtab = 0;
+        return 0;
+    }
+    if (B->strtab) {
+        return 0;
+    }
+    B->strtab = FLATCC_CALLOC(1, sizeof(struct flatcc_builder_strtab));
+    if (!B->strtab || strtab_grow(B->strtab)) {
+        strtab_free(B->strtab);
+        B->strtab = 0;
+        return -1;
+    }
+    return 0;
+}
+
+void flatcc_builder_get_string_interning_stats(flatcc_builder_t *B,
+        size_t *hits, size_t *unique)
+{
+    *hits = B->strtab ? B->strtab->hits : 0;
+    *unique = B->strtab ? B->strtab->count : 0;
+}
+
 int flatcc_builder_custom_init(flatcc_builder_t *B,
         flatcc_builder_emit_fun *emit, void *emit_context,
         flatcc_builder_alloc_fun *alloc, void *alloc_context)
@@ -472,6 +634,9 @@ int flatcc_builder_custom_reset(flatcc_builder_t *B, int set_defaults, int reduc
     if (B->refmap) {
         flatcc_refmap_reset(B->refmap);
     }
+    if (B->strtab) {
+        strtab_reset(B->strtab);
+    }
     return 0;
 }
 
@@ -495,6 +660,7 @@ void flatcc_builder_clear(flatcc_builder_t *B)
     if (B->refmap) {
         flatcc_refmap_clear(B->refmap);
     }
+    strtab_free(B->strtab);
     memset(B, 0, sizeof(*B));
 }
 
@@ -1741,10 +1907,21 @@ flatcc_builder_ref_t flatcc_builder_create_string(flatcc_builder_t *B, const cha
     uoffset_t s_pad;
     uoffset_t length_prefix;
     iov_state_t iov;
+    strtab_entry_t *e = 0;
+    uint32_t hash = 0;
+    flatcc_builder_ref_t ref;
 
     if (len > max_string_len) {
         return 0;
     }
+    if (B->strtab) {
+        hash = strtab_hash(s, len);
+        e = strtab_find(B->strtab, hash, B->nest_id, s, len);
+        if (e->ref) {
+            ++B->strtab->hits;
+            return e->ref;
+        }
+    }
     write_uoffset(&length_prefix, (uoffset_t)len);
     /* Add 1 for zero termination. */
     s_pad = front_pad(B, (uoffset_t)len + 1, field_size) + 1;
@@ -1752,7 +1929,11 @@ flatcc_builder_ref_t flatcc_builder_create_string(flatcc_builder_t *B, const cha
     push_iov(&length_prefix, field_size);
     push_iov(s, len);
     push_iov(_pad, s_pad);
-    return emit_front(B, &iov);
+    ref = emit_front(B, &iov);
+    if (e && ref) {
+        strtab_insert(B->strtab, e, hash, B->nest_id, s, len, ref);
+    }
+    return ref;
 }
 
 flatcc_builder_ref_t flatcc_builder_create_string_str(flatcc_builder_t *B, const char *s)
@@ -0,0 +1,291 @@
+#include "hmr_server.h"
+#include "watcher.h"
+#include "parser.h"
+#include "css_generator.h"
+#include "utils.h"
+
+#define HMR_MAX_REQUEST_SIZE 8192
+// A client that lets this much pile up unsent is dropped; it reconnects
+// with EventSource's retry and resyncs from `version`.
+#define HMR_MAX_WRITE_QUEUE (4 * 1024 * 1024)
+
+static const char SSE_RESPONSE_HEADERS[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/event-stream\r\n"
+    "Cache-Control: no-cache\r\n"
+    "Connection: keep-alive\r\n"
+    "\r\n";
+
+static const char NOT_FOUND_RESPONSE[] =
+    "HTTP/1.1 404 Not Found\r\n"
+    "Content-Length: 0\r\n"
+    "Connection: close\r\n"
+    "\r\n";
+
+typedef struct HmrClient {
+    uv_tcp_t tcp;
+    StringBuilder request;
+    bool streaming;
+    struct HmrClient* next;
+} HmrClient;
+
+typedef struct {
+    uv_write_t req;
+    char* data;
+} HmrWriteReq;
+
+static uv_tcp_t server;
+static bool server_running = false;
+static bool listener_registered = false;
+static HmrClient* clients = NULL;
+static uint64_t styles_version = 0;
+
+static void on_client_closed(uv_handle_t *handle) {
+    HmrClient* client = (HmrClient*)handle;
+    sb_free(&client->request);
+    free(client);
+}
+
+static void close_client(HmrClient* client) {
+    HmrClient** link = &clients;
+    while (*link && *link != client) link = &(*link)->next;
+    if (*link) *link = client->next;
+    if (!uv_is_closing((uv_handle_t*)&client->tcp)) {
+        uv_close((uv_handle_t*)&client->tcp, on_client_closed);
+    }
+}
+
+static void on_write_done(uv_write_t *req, int status) {
+    HmrWriteReq* wr = (HmrWriteReq*)req;
+    HmrClient* client = (HmrClient*)req->handle;
+    free(wr->data);
+    free(wr);
+    if (status < 0) close_client(client);
+}
+
+static void send_bytes(HmrClient* client, const char* data, size_t len) {
+    if (uv_is_closing((uv_handle_t*)&client->tcp)) return;
+    HmrWriteReq* wr = malloc(sizeof(HmrWriteReq));
+    CHECK(wr);
+    wr->data = malloc(len);
+    CHECK(wr->data);
+    memcpy(wr->data, data, len);
+
+    uv_buf_t buf = uv_buf_init(wr->data, (unsigned int)len);
+    if (uv_write(&wr->req, (uv_stream_t*)&client->tcp, &buf, 1, on_write_done) != 0) {
+        free(wr->data);
+        free(wr);
+        close_client(client);
+    } else if (client->tcp.write_queue_size > HMR_MAX_WRITE_QUEUE) {
+        close_client(client);
+    }
+}
+
+static void sb_append_json_string(StringBuilder* sb, const char* str) {
+    sb_append_n(sb, "\"", 1);
+    for (const char* p = str; *p; p++) {
+        switch (*p) {
+            case '"':  sb_append_n(sb, "\\\"", 2); break;
+            case '\\': sb_append_n(sb, "\\\\", 2); break;
+            case '\n': sb_append_n(sb, "\\n", 2); break;
+            case '\r': sb_append_n(sb, "\\r", 2); break;
+            case '\t': sb_append_n(sb, "\\t", 2); break;
+            default:
+                if ((unsigned char)*p < 0x20) {
+                    char escaped[8];
+                    snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned char)*p);
+                    sb_append_str(sb, escaped);
+                } else {
+                    sb_append_n(sb, p, 1);
+                }
+        }
+    }
+    sb_append_n(sb, "\"", 1);
+}
+
+static void append_rule_block(StringBuilder* event, const char* selector, const char* css, bool* first) {
+    if (!*first) sb_append_n(event, ",", 1);
+    *first = false;
+    sb_append_str(event, "{\"selector\":");
+    sb_append_json_string(event, selector);
+    sb_append_str(event, ",\"css\":");
+    sb_append_json_string(event, css);
+    sb_append_n(event, "}", 1);
+}
+
+static void append_added_rules(StringBuilder* event, const DataLists* added, const void* styles_buffer) {
+    bool first = true;
+    char selector[300];
+
+    for (size_t i = 0; i < added->class_count; i++) {
+        DataLists single = { .class_names = &added->class_names[i], .class_count = 1 };
+        StringBuilder css;
+        sb_init(&css, 256);
+        if (styles_buffer) generate_css(&css, &single, styles_buffer);
+        if (css.len > 0) {
+            snprintf(selector, sizeof(selector), ".%s", added->class_names[i]);
+            append_rule_block(event, selector, css.buffer, &first);
+        }
+        sb_free(&css);
+    }
+
+    for (size_t i = 0; i < added->id_count; i++) {
+        char css[320];
+        snprintf(selector, sizeof(selector), "#%s", added->injected_ids[i]);
+        snprintf(css, sizeof(css), "%s {}", selector);
+        append_rule_block(event, selector, css, &first);
+    }
+}
+
+static void append_removed_selectors(StringBuilder* event, const DataLists* removed) {
+    char selector[300];
+    bool first = true;
+
+    for (size_t i = 0; i < removed->class_count; i++) {
+        if (!first) sb_append_n(event, ",", 1);
+        first = false;
+        snprintf(selector, sizeof(selector), ".%s", removed->class_names[i]);
+        sb_append_json_string(event, selector);
+    }
+    for (size_t i = 0; i < removed->id_count; i++) {
+        if (!first) sb_append_n(event, ",", 1);
+        first = false;
+        snprintf(selector, sizeof(selector), "#%s", removed->injected_ids[i]);
+        sb_append_json_string(event, selector);
+    }
+}
+
+static void on_cycle_complete(const char* trigger_file, const DataLists* added, const DataLists* removed) {
+    if (!server_running) return;
+
+    styles_version++;
+    if (!clients) return;
+
+    char header[96];
+    snprintf(header, sizeof(header), "id: %llu\nevent: styles\ndata: {\"version\":%llu,\"file\":",
+             (unsigned long long)styles_version, (unsigned long long)styles_version);
+
+    StringBuilder event;
+    sb_init(&event, 1024);
+    sb_append_str(&event, header);
+    sb_append_json_string(&event, trigger_file);
+    sb_append_str(&event, ",\"added\":[");
+    append_added_rules(&event, added, watcher_styles_buffer());
+    sb_append_str(&event, "],\"removed\":[");
+    append_removed_selectors(&event, removed);
+    sb_append_str(&event, "]}\n\n");
+
+    HmrClient* client = clients;
+    while (client) {
+        HmrClient* next = client->next;
+        if (client->streaming) send_bytes(client, event.buffer, event.len);
+        client = next;
+    }
+    sb_free(&event);
+}
+
+static void on_shutdown_done(uv_shutdown_t *req, int status) {
+    (void)status;
+    close_client((HmrClient*)req->handle);
+    free(req);
+}
+
+static void handle_request(HmrClient* client) {
+    if (strncmp(client->request.buffer, "GET /events ", 12) != 0 &&
+        strncmp(client->request.buffer, "GET /events?", 12) != 0) {
+        send_bytes(client, NOT_FOUND_RESPONSE, sizeof(NOT_FOUND_RESPONSE) - 1);
+        uv_read_stop((uv_stream_t*)&client->tcp);
+        uv_shutdown_t* req = malloc(sizeof(uv_shutdown_t));
+        CHECK(req);
+        if (uv_shutdown(req, (uv_stream_t*)&client->tcp, on_shutdown_done) != 0) {
+            free(req);
+            close_client(client);
+        }
+        return;
+    }
+
+    char hello[96];
+    int hello_len = snprintf(hello, sizeof(hello), "retry: 1000\n: dx-styles version %llu\n\n",
+                             (unsigned long long)styles_version);
+    client->streaming = true;
+    send_bytes(client, SSE_RESPONSE_HEADERS, sizeof(SSE_RESPONSE_HEADERS) - 1);
+    send_bytes(client, hello, (size_t)hello_len);
+}
+
+static void on_alloc(uv_handle_t *handle, size_t suggested_size, uv_buf_t *buf) {
+    (void)handle;
+    buf->base = malloc(suggested_size);
+    buf->len = buf->base ? suggested_size : 0;
+}
+
+static void on_client_read(uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf) {
+    HmrClient* client = (HmrClient*)stream;
+
+    if (nread < 0) {
+        free(buf->base);
+        close_client(client);
+        return;
+    }
+
+    if (!client->streaming) {
+        sb_append_n(&client->request, buf->base, (size_t)nread);
+        if (strstr(client->request.buffer, "\r\n\r\n")) {
+            handle_request(client);
+        } else if (client->request.len > HMR_MAX_REQUEST_SIZE) {
+            close_client(client);
+        }
+    }
+    free(buf->base);
+}
+
+static void on_connection(uv_stream_t *stream, int status) {
+    if (status < 0) {
+        fprintf(stderr, "HMR connection error: %s\n", uv_strerror(status));
+        return;
+    }
+
+    HmrClient* client = calloc(1, sizeof(HmrClient));
+    CHECK(client);
+    uv_tcp_init(stream->loop, &client->tcp);
+    sb_init(&client->request, 1024);
+
+    if (uv_accept(stream, (uv_stream_t*)&client->tcp) != 0) {
+        uv_close((uv_handle_t*)&client->tcp, on_client_closed);
+        return;
+    }
+
+    uv_tcp_nodelay(&client->tcp, 1);
+    client->next = clients;
+    clients = client;
+    uv_read_start((uv_stream_t*)&client->tcp, on_alloc, on_client_read);
+}
+
+int hmr_server_start(uv_loop_t *loop, int port) {
+    struct sockaddr_in addr;
+    int r;
+
+    uv_ip4_addr("127.0.0.1", port, &addr);
+    uv_tcp_init(loop, &server);
+    if ((r = uv_tcp_bind(&server, (const struct sockaddr*)&addr, 0)) != 0 ||
+        (r = uv_listen((uv_stream_t*)&server, 128, on_connection)) != 0) {
+        fprintf(stderr, "%sCould not serve HMR events on port %d: %s%s\n", KRED, port, uv_strerror(r), KNRM);
+        uv_close((uv_handle_t*)&server, NULL);
+        return r;
+    }
+
+    server_running = true;
+    if (!listener_registered) {
+        watcher_add_listener(on_cycle_complete);
+        listener_registered = true;
+    }
+    printf("🔥 %sdx-styles%s pushing style updates on http://127.0.0.1:%d/events\n", KBLU, KNRM, port);
+    return 0;
+}
+
+void hmr_server_stop(void) {
+    if (!server_running) return;
+    server_running = false;
+
+    while (clients) close_client(clients);
+    uv_close((uv_handle_t*)&server, NULL);
+}
\ No newline at end of file
@@ -0,0 +1,22 @@
+#ifndef DX_HMR_SERVER_H
+#define DX_HMR_SERVER_H
+
+#include "common.h"
+
+#define DX_DEFAULT_HMR_PORT 35730
+
+// Server-Sent Events endpoint at http://127.0.0.1:<port>/events. After every
+// cycle that changes the stylesheet a `styles` event is pushed:
+//
+//   id: <version>
+//   event: styles
+//   data: {"version":N,"file":"...","added":[{"selector":".a","css":".a {...}"}],"removed":[".b"]}
+//
+// `version` increases monotonically for the lifetime of the process so a dev
+// server can detect dropped events and fall back to reloading styles.css.
+// No CORS header is sent: pages in the browser cannot read the stream
+// directly, the dev server relays it. Clients that stop reading are dropped.
+int hmr_server_start(uv_loop_t *loop, int port);
+void hmr_server_stop(void);
+
+#endif
\ No newline at end of file
@@ -12,10 +12,11 @@ static bool is_id_used(UsedIdNode* head, const char* id) {
 }
 
 static void add_used_id(UsedIdNode** head, const char* id) {
-    UsedIdNode* new_node = (UsedIdNode*)malloc(sizeof(UsedIdNode));
+    size_t len = strlen(id) + 1;
+    UsedIdNode* new_node = (UsedIdNode*)malloc(sizeof(UsedIdNode) + len);
     CHECK(new_node);
-    new_node->id = strdup(id);
-    CHECK(new_node->id);
+    new_node->id = (char*)(new_node + 1);
+    memcpy(new_node->id, id, len);
     new_node->next = *head;
     *head = new_node;
 }
@@ -37,6 +38,10 @@ void generate_id_prefix(char* buffer, size_t buffer_size, const char* class_name
     strncpy(buffer, temp_prefix, buffer_size);
 }
 
+void reserve_id(UsedIdNode** head, const char* id) {
+    add_used_id(head, id);
+}
+
 void get_unique_id(char* buffer, size_t buffer_size, const char* prefix, UsedIdNode** head) {
     if (!is_id_used(*head, prefix)) {
         strncpy(buffer, prefix, buffer_size);
@@ -59,7 +64,6 @@ void free_used_id_list(UsedIdNode** head) {
     UsedIdNode* current = *head;
     while (current != NULL) {
         UsedIdNode* next = current->next;
-        free(current->id);
         free(current);
         current = next;
     }
@@ -0,0 +1,102 @@
+#include "intern.h"
+
+#define INTERN_ARENA_CHUNK 65536
+#define INTERN_INITIAL_SLOTS 1024
+
+typedef struct InternArena {
+    struct InternArena* next;
+    size_t used;
+    size_t capacity;
+    char data[];
+} InternArena;
+
+typedef struct {
+    uint32_t hash;
+    const char* str;
+} InternSlot;
+
+static InternArena* arena = NULL;
+static InternSlot* slots = NULL;
+static size_t slot_count = 0;
+static size_t slot_used = 0;
+static size_t arena_bytes = 0;
+
+static uint32_t hash_bytes(const char* str, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)str[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static char* arena_alloc(size_t size) {
+    if (!arena || arena->used + size > arena->capacity) {
+        size_t capacity = size > INTERN_ARENA_CHUNK ? size : INTERN_ARENA_CHUNK;
+        InternArena* chunk = malloc(sizeof(InternArena) + capacity);
+        CHECK(chunk);
+        chunk->next = arena;
+        chunk->used = 0;
+        chunk->capacity = capacity;
+        arena = chunk;
+        arena_bytes += sizeof(InternArena) + capacity;
+    }
+    char* p = arena->data + arena->used;
+    arena->used += size;
+    return p;
+}
+
+static void grow_slots(void) {
+    size_t new_count = slot_count == 0 ? INTERN_INITIAL_SLOTS : slot_count * 2;
+    InternSlot* new_slots = calloc(new_count, sizeof(InternSlot));
+    CHECK(new_slots);
+    for (size_t i = 0; i < slot_count; i++) {
+        if (!slots[i].str) continue;
+        size_t j = slots[i].hash & (new_count - 1);
+        while (new_slots[j].str) j = (j + 1) & (new_count - 1);
+        new_slots[j] = slots[i];
+    }
+    free(slots);
+    slots = new_slots;
+    slot_count = new_count;
+}
+
+const char* intern_string_n(const char* str, size_t len) {
+    if (slot_used * 4 >= slot_count * 3) grow_slots();
+
+    uint32_t hash = hash_bytes(str, len);
+    size_t i = hash & (slot_count - 1);
+    while (slots[i].str) {
+        if (slots[i].hash == hash && strncmp(slots[i].str, str, len) == 0 && slots[i].str[len] == '\0') {
+            return slots[i].str;
+        }
+        i = (i + 1) & (slot_count - 1);
+    }
+
+    char* copy = arena_alloc(len + 1);
+    memcpy(copy, str, len);
+    copy[len] = '\0';
+    slots[i].hash = hash;
+    slots[i].str = copy;
+    slot_used++;
+    return copy;
+}
+
+const char* intern_string(const char* str) {
+    return intern_string_n(str, strlen(str));
+}
+
+size_t intern_memory_usage(void) {
+    return arena_bytes + slot_count * sizeof(InternSlot);
+}
+
+void intern_free_all(void) {
+    while (arena) {
+        InternArena* next = arena->next;
+        free(arena);
+        arena = next;
+    }
+    free(slots);
+    slots = NULL;
+    slot_count = slot_used = arena_bytes = 0;
+}
\ No newline at end of file
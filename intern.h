@@ -0,0 +1,13 @@
+#ifndef DX_INTERN_H
+#define DX_INTERN_H
+
+#include "common.h"
+
+// Process-wide string pool. Interned strings are immutable, never freed and
+// unique by content, so two interned pointers are equal iff the strings are.
+const char* intern_string_n(const char* str, size_t len);
+const char* intern_string(const char* str);
+size_t intern_memory_usage(void);
+void intern_free_all(void);
+
+#endif
\ No newline at end of file
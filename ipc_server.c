@@ -0,0 +1,311 @@
+#include "ipc_server.h"
+#include "watcher.h"
+#include "parser.h"
+#include "css_generator.h"
+#include "utils.h"
+#include "trace.h"
+
+// Longest request line accepted; a client that sends more without a newline
+// is told so and disconnected rather than buffered indefinitely.
+#define IPC_MAX_LINE_SIZE 65536
+
+typedef struct IpcClient {
+    uv_pipe_t pipe;
+    StringBuilder inbox;
+    bool subscribed;
+    struct IpcClient* next;
+} IpcClient;
+
+typedef struct {
+    uv_write_t req;
+    char* data;
+} IpcWriteReq;
+
+static uv_pipe_t server;
+static bool server_running = false;
+static bool listener_registered = false;
+static char* server_path = NULL;
+static IpcClient* clients = NULL;
+
+static void on_write_done(uv_write_t *req, int status) {
+    (void)status;
+    IpcWriteReq* wr = (IpcWriteReq*)req;
+    free(wr->data);
+    free(wr);
+}
+
+static void send_frame(IpcClient* client, const char* status, const char* payload, size_t len) {
+    char header[64];
+    int header_len = snprintf(header, sizeof(header), "%s %zu\n", status, len);
+
+    IpcWriteReq* wr = malloc(sizeof(IpcWriteReq));
+    CHECK(wr);
+    wr->data = malloc(header_len + len);
+    CHECK(wr->data);
+    memcpy(wr->data, header, header_len);
+    if (len > 0) memcpy(wr->data + header_len, payload, len);
+
+    uv_buf_t buf = uv_buf_init(wr->data, (unsigned int)(header_len + len));
+    if (uv_write(&wr->req, (uv_stream_t*)&client->pipe, &buf, 1, on_write_done) != 0) {
+        free(wr->data);
+        free(wr);
+    }
+}
+
+static void send_error(IpcClient* client, const char* message) {
+    IpcWriteReq* wr = malloc(sizeof(IpcWriteReq));
+    CHECK(wr);
+    size_t len = strlen(message) + 5;
+    wr->data = malloc(len + 1);
+    CHECK(wr->data);
+    snprintf(wr->data, len + 1, "ERR %s\n", message);
+
+    uv_buf_t buf = uv_buf_init(wr->data, (unsigned int)len);
+    if (uv_write(&wr->req, (uv_stream_t*)&client->pipe, &buf, 1, on_write_done) != 0) {
+        free(wr->data);
+        free(wr);
+    }
+}
+
+static void on_client_closed(uv_handle_t *handle) {
+    IpcClient* client = (IpcClient*)handle;
+    sb_free(&client->inbox);
+    free(client);
+}
+
+static void unlink_client(IpcClient* client) {
+    IpcClient** link = &clients;
+    while (*link && *link != client) link = &(*link)->next;
+    if (*link) *link = client->next;
+}
+
+static void close_client(IpcClient* client) {
+    unlink_client(client);
+    if (!uv_is_closing((uv_handle_t*)&client->pipe)) {
+        uv_close((uv_handle_t*)&client->pipe, on_client_closed);
+    }
+}
+
+static void on_client_shutdown(uv_shutdown_t *req, int status) {
+    (void)status;
+    IpcClient* client = (IpcClient*)req->data;
+    free(req);
+    if (!uv_is_closing((uv_handle_t*)&client->pipe)) {
+        uv_close((uv_handle_t*)&client->pipe, on_client_closed);
+    }
+}
+
+// Lets the queued error reply drain before the pipe is closed.
+static void reject_client(IpcClient* client, const char* message) {
+    send_error(client, message);
+    unlink_client(client);
+    uv_read_stop((uv_stream_t*)&client->pipe);
+    uv_shutdown_t* req = malloc(sizeof(uv_shutdown_t));
+    CHECK(req);
+    req->data = client;
+    if (uv_shutdown(req, (uv_stream_t*)&client->pipe, on_client_shutdown) != 0) {
+        free(req);
+        close_client(client);
+    }
+}
+
+static void handle_css(IpcClient* client, char* args) {
+    const void* styles_buffer = watcher_styles_buffer();
+    if (!styles_buffer) {
+        send_error(client, "styles.bin not loaded");
+        return;
+    }
+
+    // Query names point into the request line; interning them would let
+    // clients grow the process-wide pool without bound.
+    size_t capacity = 1;
+    for (const char* p = args; *p; p++) {
+        if (*p == ' ' || *p == '\t') capacity++;
+    }
+    DataLists query = {0};
+    query.class_names = malloc(capacity * sizeof(char*));
+    CHECK(query.class_names);
+    for (char* token = strtok(args, " \t"); token; token = strtok(NULL, " \t")) {
+        query.class_names[query.class_count++] = token;
+    }
+
+    StringBuilder sb;
+    sb_init(&sb, 1024);
+    generate_css(&sb, &query, styles_buffer);
+    send_frame(client, "OK", sb.buffer, sb.len);
+    sb_free(&sb);
+    free(query.class_names);
+}
+
+static void handle_classes(IpcClient* client, const char* path) {
+    const DataLists* data = watcher_file_data(path);
+    if (!data && strncmp(path, "./", 2) != 0) {
+        char prefixed[512];
+        snprintf(prefixed, sizeof(prefixed), "./%s", path);
+        data = watcher_file_data(prefixed);
+    }
+    if (!data) {
+        send_error(client, "unknown file");
+        return;
+    }
+
+    StringBuilder sb;
+    sb_init(&sb, 256);
+    for (size_t i = 0; i < data->class_count; i++) {
+        if (i > 0) sb_append_n(&sb, " ", 1);
+        sb_append_str(&sb, data->class_names[i]);
+    }
+    sb_append_n(&sb, "\n", 1);
+    send_frame(client, "OK", sb.buffer, sb.len);
+    sb_free(&sb);
+}
+
+static void handle_command(IpcClient* client, char* line) {
+    char* args = strchr(line, ' ');
+    if (args) *args++ = '\0';
+    else args = line + strlen(line);
+
+    if (strcmp(line, "PING") == 0) {
+        send_frame(client, "OK", "pong\n", 5);
+    } else if (strcmp(line, "CSS") == 0) {
+        handle_css(client, args);
+    } else if (strcmp(line, "CLASSES") == 0) {
+        handle_classes(client, args);
+    } else if (strcmp(line, "STATS") == 0) {
+        StringBuilder sb;
+        sb_init(&sb, 2048);
+        trace_format_stats(&sb);
+        send_frame(client, "OK", sb.buffer, sb.len);
+        sb_free(&sb);
+    } else if (strcmp(line, "SUBSCRIBE") == 0) {
+        client->subscribed = true;
+        send_frame(client, "OK", NULL, 0);
+    } else {
+        send_error(client, "unknown command");
+    }
+}
+
+static void on_alloc(uv_handle_t *handle, size_t suggested_size, uv_buf_t *buf) {
+    (void)handle;
+    buf->base = malloc(suggested_size);
+    buf->len = buf->base ? suggested_size : 0;
+}
+
+static void on_client_read(uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf) {
+    IpcClient* client = (IpcClient*)stream;
+
+    if (nread < 0) {
+        free(buf->base);
+        close_client(client);
+        return;
+    }
+
+    sb_append_n(&client->inbox, buf->base, (size_t)nread);
+    free(buf->base);
+
+    char* line = client->inbox.buffer;
+    char* newline;
+    while ((newline = memchr(line, '\n', client->inbox.len - (line - client->inbox.buffer)))) {
+        *newline = '\0';
+        if (newline > line && newline[-1] == '\r') newline[-1] = '\0';
+        if (*line) handle_command(client, line);
+        line = newline + 1;
+    }
+
+    size_t consumed = line - client->inbox.buffer;
+    if (consumed > 0) {
+        memmove(client->inbox.buffer, line, client->inbox.len - consumed + 1);
+        client->inbox.len -= consumed;
+    }
+    if (client->inbox.len > IPC_MAX_LINE_SIZE) {
+        reject_client(client, "request line too long");
+    }
+}
+
+static void on_connection(uv_stream_t *stream, int status) {
+    if (status < 0) {
+        fprintf(stderr, "IPC connection error: %s\n", uv_strerror(status));
+        return;
+    }
+
+    IpcClient* client = calloc(1, sizeof(IpcClient));
+    CHECK(client);
+    uv_pipe_init(stream->loop, &client->pipe, 0);
+    sb_init(&client->inbox, 256);
+
+    if (uv_accept(stream, (uv_stream_t*)&client->pipe) != 0) {
+        uv_close((uv_handle_t*)&client->pipe, on_client_closed);
+        return;
+    }
+
+    client->next = clients;
+    clients = client;
+    uv_read_start((uv_stream_t*)&client->pipe, on_alloc, on_client_read);
+}
+
+static void append_diff_lines(StringBuilder* sb, const DataLists* data, char sign) {
+    char line[300];
+    for (size_t i = 0; i < data->class_count; i++) {
+        snprintf(line, sizeof(line), "%c%s\n", sign, data->class_names[i]);
+        sb_append_str(sb, line);
+    }
+    for (size_t i = 0; i < data->id_count; i++) {
+        snprintf(line, sizeof(line), "%c#%s\n", sign, data->injected_ids[i]);
+        sb_append_str(sb, line);
+    }
+}
+
+static void on_cycle_complete(const char* trigger_file, const DataLists* added, const DataLists* removed) {
+    if (!server_running) return;
+
+    StringBuilder sb;
+    sb_init(&sb, 256);
+    sb_append_str(&sb, trigger_file);
+    sb_append_n(&sb, "\n", 1);
+    append_diff_lines(&sb, added, '+');
+    append_diff_lines(&sb, removed, '-');
+
+    for (IpcClient* client = clients; client; client = client->next) {
+        if (client->subscribed) send_frame(client, "EVENT", sb.buffer, sb.len);
+    }
+    sb_free(&sb);
+}
+
+int ipc_server_start(uv_loop_t *loop, const char* socket_path) {
+    int r;
+    uv_fs_t unlink_req;
+    uv_fs_unlink(NULL, &unlink_req, socket_path, NULL);
+    uv_fs_req_cleanup(&unlink_req);
+
+    uv_pipe_init(loop, &server, 0);
+    if ((r = uv_pipe_bind(&server, socket_path)) != 0 ||
+        (r = uv_listen((uv_stream_t*)&server, 128, on_connection)) != 0) {
+        fprintf(stderr, "%sCould not serve on '%s': %s%s\n", KRED, socket_path, uv_strerror(r), KNRM);
+        uv_close((uv_handle_t*)&server, NULL);
+        return r;
+    }
+
+    server_path = strdup(socket_path);
+    CHECK(server_path);
+    server_running = true;
+    if (!listener_registered) {
+        watcher_add_listener(on_cycle_complete);
+        listener_registered = true;
+    }
+    printf("🔌 %sdx-styles%s serving queries on '%s'\n", KBLU, KNRM, socket_path);
+    return 0;
+}
+
+void ipc_server_stop(void) {
+    if (!server_running) return;
+    server_running = false;
+
+    while (clients) close_client(clients);
+    uv_close((uv_handle_t*)&server, NULL);
+
+    uv_fs_t unlink_req;
+    uv_fs_unlink(NULL, &unlink_req, server_path, NULL);
+    uv_fs_req_cleanup(&unlink_req);
+    free(server_path);
+    server_path = NULL;
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#ifndef DX_IPC_SERVER_H
+#define DX_IPC_SERVER_H
+
+#include "common.h"
+
+#define DX_DEFAULT_SOCKET_PATH ".dx-styles.sock"
+
+// Line-oriented query protocol served over a Unix domain socket.
+//
+//   PING                      -> OK <len>\n pong
+//   CSS <class> [<class>...]  -> OK <len>\n <css for the listed classes>
+//   CLASSES <path>            -> OK <len>\n <space separated classes of path>
+//   STATS                     -> OK <len>\n <per-phase latency table, see --stats>
+//   SUBSCRIBE                 -> OK 0\n, then EVENT <len>\n <diff> after every cycle
+//
+// Failures are answered with a single `ERR <message>\n` line. Diff payloads
+// hold one `+name`/`-name` per line, ids are prefixed with `#`.
+int ipc_server_start(uv_loop_t *loop, const char* socket_path);
+void ipc_server_stop(void);
+
+#endif
\ No newline at end of file
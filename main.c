@@ -1,17 +1,89 @@
 #include "common.h"
 #include "watcher.h"
+#include "ipc_server.h"
+#include "hmr_server.h"
+#include "trace.h"
+#include "parser.h"
+#include "intern.h"
+#include "dir_watch.h"
+#include "read_pipeline.h"
 
 static uv_loop_t *loop;
+static uv_signal_t sigint_handle;
+static uv_signal_t sigterm_handle;
+static bool shutdown_requested = false;
+
+static void on_shutdown_signal(uv_signal_t *handle, int signum) {
+    (void)signum;
+    shutdown_requested = true;
+    uv_stop(handle->loop);
+}
 
 void cleanup() {
+    ipc_server_stop();
+    hmr_server_stop();
+    if (uv_is_active((uv_handle_t*)&sigint_handle)) {
+        uv_close((uv_handle_t*)&sigint_handle, NULL);
+        uv_close((uv_handle_t*)&sigterm_handle, NULL);
+    }
     cleanup_watcher();
     uv_run(loop, UV_RUN_NOWAIT); 
     uv_loop_close(loop);
+    trace_shutdown();
+    intern_free_all();
+}
+
+static void print_usage(const char* program) {
+    fprintf(stderr, "Usage: %s [--daemon [socket_path]] [--hmr [port]] [--stats] [--trace <file.json>] [--memory-budget <MB>] [--watch-backend inotify|fanotify]\n", program);
 }
 
 int main(int argc, char *argv[]) {
+    const char* socket_path = NULL;
+    int hmr_port = 0;
+    bool collect_stats = false;
+    const char* trace_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--daemon") == 0) {
+            socket_path = (i + 1 < argc && argv[i + 1][0] != '-') ? argv[++i] : DX_DEFAULT_SOCKET_PATH;
+        } else if (strcmp(argv[i], "--hmr") == 0) {
+            hmr_port = (i + 1 < argc && argv[i + 1][0] != '-') ? atoi(argv[++i]) : DX_DEFAULT_HMR_PORT;
+            if (hmr_port <= 0 || hmr_port > 65535) {
+                fprintf(stderr, "Invalid HMR port\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            collect_stats = true;
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (strcmp(argv[i], "--memory-budget") == 0 && i + 1 < argc) {
+            long budget_mb = atol(argv[++i]);
+            if (budget_mb <= 0) {
+                fprintf(stderr, "Invalid memory budget\n");
+                return 1;
+            }
+            parser_set_memory_budget((size_t)budget_mb << 20);
+            // Half is left for the parser's own buffers and the generated CSS.
+            read_pipeline_set_byte_limit((size_t)budget_mb << 19);
+        } else if (strcmp(argv[i], "--watch-backend") == 0 && i + 1 < argc) {
+            const char* backend = argv[++i];
+            if (strcmp(backend, "fanotify") == 0) {
+                dir_watch_set_backend(DIR_WATCH_FANOTIFY);
+            } else if (strcmp(backend, "inotify") == 0) {
+                dir_watch_set_backend(DIR_WATCH_INOTIFY);
+            } else {
+                fprintf(stderr, "Unknown watch backend '%s'\n", backend);
+                return 1;
+            }
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
     loop = uv_default_loop();
     atexit(cleanup);
+    trace_init(collect_stats, trace_path);
 
     srand((unsigned int)time(NULL));
 
@@ -19,5 +91,22 @@ int main(int argc, char *argv[]) {
 
     start_watching(loop, "./src");
 
-    return uv_run(loop, UV_RUN_DEFAULT);
+    if (socket_path && ipc_server_start(loop, socket_path) != 0) {
+        return 1;
+    }
+    if (hmr_port && hmr_server_start(loop, hmr_port) != 0) {
+        return 1;
+    }
+
+    if (socket_path || hmr_port || trace_enabled()) {
+        uv_signal_init(loop, &sigint_handle);
+        uv_signal_init(loop, &sigterm_handle);
+        uv_signal_start(&sigint_handle, on_shutdown_signal, SIGINT);
+        uv_signal_start(&sigterm_handle, on_shutdown_signal, SIGTERM);
+    }
+
+    // uv_run reports the handles uv_stop left active; a requested stop is
+    // still a clean exit.
+    int r = uv_run(loop, UV_RUN_DEFAULT);
+    return shutdown_requested ? 0 : r;
 }
\ No newline at end of file
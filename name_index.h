@@ -0,0 +1,40 @@
+#ifndef DX_NAME_INDEX_H
+#define DX_NAME_INDEX_H
+
+#include <stdint.h>
+
+// Minimal perfect hash over the static rule names, written by
+// styles_generator into Styles.name_index as
+//
+//   [bucket_count, displacement[bucket_count], rule[rule_count]]
+//
+// A name hashes to a bucket whose displacement (d0 * rule_count + d1) moves
+// it to a unique slot, and rule[slot] is its position in static_rules. Names
+// that are not in the table also land on some slot, so a hit has to be
+// confirmed by comparing the rule's name.
+#define NAME_INDEX_BUCKET_LOAD 2
+
+typedef struct {
+    uint32_t bucket;
+    uint32_t f1, f2;
+} NameHash;
+
+static inline NameHash name_index_hash(const char *name, uint32_t bucket_count, uint32_t rule_count) {
+    uint64_t h = 14695981039346656037ULL;
+    for (const unsigned char *p = (const unsigned char *)name; *p; p++) {
+        h ^= *p;
+        h *= 1099511628211ULL;
+    }
+    NameHash k;
+    k.bucket = (uint32_t)(h >> 32) % bucket_count;
+    k.f1 = (uint32_t)h % rule_count;
+    k.f2 = (uint32_t)((h * 0x9E3779B97F4A7C15ULL) >> 32) % rule_count;
+    return k;
+}
+
+static inline uint32_t name_index_slot(NameHash k, uint32_t displacement, uint32_t rule_count) {
+    uint64_t d0 = displacement / rule_count, d1 = displacement % rule_count;
+    return (uint32_t)((k.f1 + d0 * k.f2 + d1) % rule_count);
+}
+
+#endif
\ No newline at end of file
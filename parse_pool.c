@@ -0,0 +1,192 @@
+#include "parse_pool.h"
+
+#define PARSE_POOL_MAX_WORKERS 64
+
+// Each worker owns a deque. Jobs are dealt round-robin; an owner takes its
+// oldest job so files finish roughly in submission order, and an idle
+// worker steals the newest job from the back of someone else's deque.
+typedef struct {
+    uv_mutex_t lock;
+    ParseJob** jobs;
+    size_t head;
+    size_t count;
+    size_t capacity;
+    uv_thread_t thread;
+} ParseWorker;
+
+static ParseWorker workers[PARSE_POOL_MAX_WORKERS];
+static unsigned int worker_count = 0;
+static unsigned int next_worker = 0;
+
+// `queued` counts jobs no worker has claimed yet; claiming one under
+// `idle_lock` guarantees a job is waiting in some deque.
+static uv_mutex_t idle_lock;
+static uv_cond_t idle_cond;
+static size_t queued = 0;
+static bool stopping = false;
+
+static uv_async_t done_async;
+static uv_mutex_t done_lock;
+static ParseJob* done_jobs = NULL;
+static size_t outstanding = 0;
+
+static void deque_push_back(ParseWorker* w, ParseJob* job) {
+    uv_mutex_lock(&w->lock);
+    if (w->count == w->capacity) {
+        size_t capacity = w->capacity == 0 ? 64 : w->capacity * 2;
+        ParseJob** jobs = malloc(capacity * sizeof(ParseJob*));
+        CHECK(jobs);
+        for (size_t i = 0; i < w->count; i++) jobs[i] = w->jobs[(w->head + i) % w->capacity];
+        free(w->jobs);
+        w->jobs = jobs;
+        w->head = 0;
+        w->capacity = capacity;
+    }
+    w->jobs[(w->head + w->count) % w->capacity] = job;
+    w->count++;
+    uv_mutex_unlock(&w->lock);
+}
+
+static ParseJob* deque_pop_front(ParseWorker* w) {
+    ParseJob* job = NULL;
+    uv_mutex_lock(&w->lock);
+    if (w->count > 0) {
+        job = w->jobs[w->head];
+        w->head = (w->head + 1) % w->capacity;
+        w->count--;
+    }
+    uv_mutex_unlock(&w->lock);
+    return job;
+}
+
+static ParseJob* deque_pop_back(ParseWorker* w) {
+    ParseJob* job = NULL;
+    uv_mutex_lock(&w->lock);
+    if (w->count > 0) {
+        w->count--;
+        job = w->jobs[(w->head + w->count) % w->capacity];
+    }
+    uv_mutex_unlock(&w->lock);
+    return job;
+}
+
+static ParseJob* take_job(unsigned int self) {
+    ParseJob* job = deque_pop_front(&workers[self]);
+    for (unsigned int i = 1; !job && i < worker_count; i++) {
+        job = deque_pop_back(&workers[(self + i) % worker_count]);
+    }
+    return job;
+}
+
+static void worker_main(void* arg) {
+    unsigned int self = (unsigned int)(uintptr_t)arg;
+    for (;;) {
+        uv_mutex_lock(&idle_lock);
+        while (queued == 0 && !stopping) uv_cond_wait(&idle_cond, &idle_lock);
+        if (queued == 0) {
+            uv_mutex_unlock(&idle_lock);
+            return;
+        }
+        queued--;
+        uv_mutex_unlock(&idle_lock);
+
+        ParseJob* job;
+        while (!(job = take_job(self))) {}
+        job->work(job);
+
+        uv_mutex_lock(&done_lock);
+        job->next = done_jobs;
+        done_jobs = job;
+        uv_mutex_unlock(&done_lock);
+        uv_async_send(&done_async);
+    }
+}
+
+static void on_jobs_done(uv_async_t* handle) {
+    (void)handle;
+    uv_mutex_lock(&done_lock);
+    ParseJob* list = done_jobs;
+    done_jobs = NULL;
+    uv_mutex_unlock(&done_lock);
+
+    ParseJob* ordered = NULL;
+    while (list) {
+        ParseJob* next = list->next;
+        list->next = ordered;
+        ordered = list;
+        list = next;
+    }
+    while (ordered) {
+        ParseJob* next = ordered->next;
+        outstanding--;
+        ordered->done(ordered);
+        ordered = next;
+    }
+    // The handle only keeps the loop alive while jobs are in flight.
+    if (outstanding == 0) uv_unref((uv_handle_t*)&done_async);
+}
+
+int parse_pool_start(uv_loop_t* loop, unsigned int count) {
+    if (count == 0) count = uv_available_parallelism();
+    if (count > PARSE_POOL_MAX_WORKERS) count = PARSE_POOL_MAX_WORKERS;
+
+    int r = uv_async_init(loop, &done_async, on_jobs_done);
+    if (r != 0) return r;
+    uv_unref((uv_handle_t*)&done_async);
+    CHECK(uv_mutex_init(&idle_lock) == 0);
+    CHECK(uv_cond_init(&idle_cond) == 0);
+    CHECK(uv_mutex_init(&done_lock) == 0);
+    stopping = false;
+
+    for (worker_count = 0; worker_count < count; worker_count++) {
+        ParseWorker* w = &workers[worker_count];
+        memset(w, 0, sizeof(*w));
+        CHECK(uv_mutex_init(&w->lock) == 0);
+        r = uv_thread_create(&w->thread, worker_main, (void*)(uintptr_t)worker_count);
+        if (r != 0) {
+            uv_mutex_destroy(&w->lock);
+            break;
+        }
+    }
+    if (worker_count == 0) {
+        parse_pool_stop();
+        return r;
+    }
+    return 0;
+}
+
+void parse_pool_submit(ParseJob* job) {
+    CHECK(worker_count > 0);
+    deque_push_back(&workers[next_worker], job);
+    next_worker = (next_worker + 1) % worker_count;
+
+    uv_mutex_lock(&idle_lock);
+    queued++;
+    uv_cond_signal(&idle_cond);
+    uv_mutex_unlock(&idle_lock);
+
+    if (outstanding++ == 0) uv_ref((uv_handle_t*)&done_async);
+}
+
+// Finishes the queued jobs, joins the workers and closes the handle; the
+// caller runs the loop once more to complete the close.
+void parse_pool_stop(void) {
+    uv_mutex_lock(&idle_lock);
+    stopping = true;
+    uv_cond_broadcast(&idle_cond);
+    uv_mutex_unlock(&idle_lock);
+
+    for (unsigned int i = 0; i < worker_count; i++) {
+        uv_thread_join(&workers[i].thread);
+        uv_mutex_destroy(&workers[i].lock);
+        free(workers[i].jobs);
+    }
+    worker_count = 0;
+    next_worker = 0;
+
+    on_jobs_done(&done_async);
+    uv_close((uv_handle_t*)&done_async, NULL);
+    uv_mutex_destroy(&idle_lock);
+    uv_cond_destroy(&idle_cond);
+    uv_mutex_destroy(&done_lock);
+}
\ No newline at end of file
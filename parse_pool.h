@@ -0,0 +1,19 @@
+#ifndef DX_PARSE_POOL_H
+#define DX_PARSE_POOL_H
+
+#include "common.h"
+
+// CPU-bound jobs run on the pool's own threads so they never queue behind
+// (or in front of) fs requests in libuv's shared threadpool. `work` runs on a
+// worker; `done` runs afterwards on the loop thread the pool was started on.
+typedef struct ParseJob {
+    void (*work)(struct ParseJob* job);
+    void (*done)(struct ParseJob* job);
+    struct ParseJob* next;
+} ParseJob;
+
+int parse_pool_start(uv_loop_t* loop, unsigned int workers);
+void parse_pool_submit(ParseJob* job);
+void parse_pool_stop(void);
+
+#endif
\ No newline at end of file
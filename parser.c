@@ -2,6 +2,8 @@
 #include "file_io.h"
 #include "utils.h"
 #include "id_generator.h"
+#include "trace.h"
+#include "intern.h"
 
 static bool is_dx_id(const char* id) {
     size_t len = strlen(id);
@@ -15,20 +17,129 @@ static bool is_dx_id(const char* id) {
     return i == len;
 }
 
-int process_file(const char* filename, UsedIdNode** used_ids_head) {
-    size_t size;
-    char *source = map_file_read(filename, &size);
-    if (!source) return 0;
+#define STREAM_MIN_CHUNK 4096
+#define STREAM_MAX_CHUNK (1 << 20)
+#define PATTERN_TAIL 10 // strlen("className="), the longest pattern that may straddle a chunk
 
-    StringBuilder sb;
-    sb_init(&sb, size + 4096);
+static size_t stream_threshold = 0;
+static size_t stream_chunk_size = 0;
+
+void parser_set_memory_budget(size_t budget_bytes) {
+    if (budget_bytes == 0) {
+        stream_threshold = 0;
+        stream_chunk_size = 0;
+        return;
+    }
+    stream_chunk_size = budget_bytes / 16;
+    if (stream_chunk_size < STREAM_MIN_CHUNK) stream_chunk_size = STREAM_MIN_CHUNK;
+    if (stream_chunk_size > STREAM_MAX_CHUNK) stream_chunk_size = STREAM_MAX_CHUNK;
+    stream_threshold = budget_bytes / 4;
+    if (stream_threshold < stream_chunk_size) stream_threshold = stream_chunk_size;
+}
+
+bool parser_streams_size(size_t size) {
+    return stream_threshold != 0 && size > stream_threshold;
+}
+
+static bool should_stream(const char* filename) {
+    if (stream_threshold == 0) return false;
+    uv_fs_t stat_req;
+    bool large = uv_fs_stat(NULL, &stat_req, filename, NULL) == 0 &&
+                 stat_req.statbuf.st_size > stream_threshold;
+    uv_fs_req_cleanup(&stat_req);
+    return large;
+}
+
+typedef enum {
+    TAG_EDIT_KEEP,    // an id is allocated but the tag is passed through
+    TAG_EDIT_REPLACE, // [start, end) holds the old id value
+    TAG_EDIT_INJECT   // ` id="..."` goes in at start
+} TagEditKind;
+
+typedef struct {
+    size_t start;
+    size_t end;
+    TagEditKind kind;
+    char id_prefix[8];
+} TagEdit;
+
+// The output of a scan is the source up to `end` with `edits` applied in
+// order. Scanning touches no shared state, so it can run on a parse worker;
+// only applying the plan allocates ids.
+struct TagPlan {
+    TagEdit* edits;
+    size_t count;
+    size_t capacity;
+    size_t end;
+    uint64_t scan_start;
+    uint64_t scan_ns;
+};
+
+static void plan_tag(TagPlan* plan, const char* source, const char* tag_start, const char* class_name_ptr, const char* tag_end) {
+    const char *class_val_start = strchr(class_name_ptr, '"') + 1;
+    const char *class_val_end = strchr(class_val_start, '"');
+    if (!class_val_start || !class_val_end || class_val_end > tag_end) return;
+    size_t class_name_len = class_val_end - class_val_start;
+    char class_name_val[512];
+    if (class_name_len >= sizeof(class_name_val)) return;
+    memcpy(class_name_val, class_val_start, class_name_len);
+    class_name_val[class_name_len] = '\0';
+
+    if (plan->count >= plan->capacity) {
+        plan->capacity = plan->capacity == 0 ? 16 : plan->capacity * 2;
+        plan->edits = realloc(plan->edits, plan->capacity * sizeof(TagEdit));
+        CHECK(plan->edits);
+    }
+    TagEdit* edit = &plan->edits[plan->count++];
+    generate_id_prefix(edit->id_prefix, sizeof(edit->id_prefix), class_name_val);
+
+    const char *id_ptr = NULL;
+    for (const char* p = tag_start; p < tag_end; ++p) {
+        if ((*p == ' ' || *p == '<') && strncmp(p + 1, "id=", 3) == 0) {
+            id_ptr = p + 1;
+            break;
+        }
+    }
+
+    if (id_ptr) {
+        const char* id_val_start = strchr(id_ptr, '"') + 1;
+        const char* id_val_end = strchr(id_val_start, '"');
+
+        if (!id_val_start || !id_val_end || id_val_end > tag_end) {
+            edit->kind = TAG_EDIT_KEEP;
+            edit->start = edit->end = tag_start - source;
+        } else {
+            edit->kind = TAG_EDIT_REPLACE;
+            edit->start = id_val_start - source;
+            edit->end = id_val_end - source;
+        }
+    } else {
+        edit->kind = TAG_EDIT_INJECT;
+        edit->start = edit->end = class_val_end + 1 - source;
+    }
+}
+
+// Scans the NUL-terminated `source` of length `len` into `plan` and returns
+// how many bytes were consumed. Unless `final` is set, it stops in front of
+// anything that may continue in the next chunk (an unterminated tag, the last
+// '<' or a partial "className=") so the caller can carry that tail over.
+static size_t scan_tags(TagPlan* plan, const char* source, size_t len, bool final) {
     const char *cursor = source;
+    const char *source_end = source + len;
+    plan->count = 0;
 
     while (*cursor) {
         const char *class_name_ptr = strstr(cursor, "className=");
         if (!class_name_ptr) {
-            sb_append_str(&sb, cursor);
-            break;
+            if (final) {
+                plan->end = cursor - source + strlen(cursor);
+                return len;
+            }
+            const char* carry = len - (cursor - source) > PATTERN_TAIL ? source_end - PATTERN_TAIL : cursor;
+            const char* last_tag = strrchr(cursor, '<');
+            if (last_tag && last_tag < carry) carry = last_tag;
+            plan->end = carry - source;
+            return plan->end;
         }
 
         const char *tag_start = NULL;
@@ -39,85 +150,389 @@ int process_file(const char* filename, UsedIdNode** used_ids_head) {
             }
         }
         if (!tag_start) {
-            sb_append_n(&sb, cursor, class_name_ptr - cursor + 1);
             cursor = class_name_ptr + 1;
             continue;
         }
 
         const char *tag_end = strchr(tag_start, '>');
         if (!tag_end) {
-            sb_append_str(&sb, cursor);
-            break;
+            if (final) {
+                plan->end = cursor - source + strlen(cursor);
+                return len;
+            }
+            plan->end = tag_start - source;
+            return plan->end;
         }
 
-        sb_append_n(&sb, cursor, tag_start - cursor);
+        plan_tag(plan, source, tag_start, class_name_ptr, tag_end);
+        cursor = tag_end + 1;
+    }
+    plan->end = cursor - source;
+    return plan->end;
+}
 
-        const char *class_val_start = strchr(class_name_ptr, '"') + 1;
-        const char *class_val_end = strchr(class_val_start, '"');
-        if (!class_val_start || !class_val_end || class_val_end > tag_end) {
-            sb_append_n(&sb, tag_start, tag_end - tag_start + 1);
-            cursor = tag_end + 1;
-            continue;
-        }
-        size_t class_name_len = class_val_end - class_val_start;
-        char class_name_val[512];
-        if (class_name_len < sizeof(class_name_val)) {
-            strncpy(class_name_val, class_val_start, class_name_len);
-            class_name_val[class_name_len] = '\0';
+static void apply_plan(StringBuilder* sb, const char* source, const TagPlan* plan,
+                       UsedIdNode** used_ids_head, uint64_t* id_alloc_ns) {
+    size_t pos = 0;
+    for (size_t i = 0; i < plan->count; i++) {
+        const TagEdit* edit = &plan->edits[i];
+        uint64_t id_start = trace_begin();
+        char final_id[512];
+        get_unique_id(final_id, sizeof(final_id), edit->id_prefix, used_ids_head);
+        if (id_start) *id_alloc_ns += uv_hrtime() - id_start;
+        if (edit->kind == TAG_EDIT_KEEP) continue;
+
+        sb_append_n(sb, source + pos, edit->start - pos);
+        if (edit->kind == TAG_EDIT_REPLACE) {
+            sb_append_str(sb, final_id);
         } else {
-            sb_append_n(&sb, tag_start, tag_end - tag_start + 1);
-            cursor = tag_end + 1;
-            continue;
+            char id_attr[576];
+            snprintf(id_attr, sizeof(id_attr), " id=\"%s\"", final_id);
+            sb_append_str(sb, id_attr);
         }
+        pos = edit->end;
+    }
+    sb_append_n(sb, source + pos, plan->end - pos);
+}
 
-        char id_prefix[8];
-        generate_id_prefix(id_prefix, sizeof(id_prefix), class_name_val);
+TagPlan* parser_scan_buffer(const char* source, size_t size) {
+    TagPlan* plan = calloc(1, sizeof(TagPlan));
+    CHECK(plan);
+    plan->scan_start = trace_begin();
+    scan_tags(plan, source, size, true);
+    if (plan->scan_start) plan->scan_ns = uv_hrtime() - plan->scan_start;
+    return plan;
+}
 
-        char final_id[512];
-        get_unique_id(final_id, sizeof(final_id), id_prefix, used_ids_head);
+void tag_plan_free(TagPlan* plan) {
+    if (!plan) return;
+    free(plan->edits);
+    free(plan);
+}
 
-        const char *id_ptr = NULL;
-        for (const char* p = tag_start; p < tag_end; ++p) {
-            if ((*p == ' ' || *p == '<') && strncmp(p + 1, "id=", 3) == 0) {
-                id_ptr = p + 1;
-                break;
+static int process_file_streamed(const char* filename, UsedIdNode** used_ids_head) {
+    // The temp file is renamed over the symlink's target, not the link, and
+    // takes the source's permission bits before it replaces it.
+    uv_fs_t req;
+    char target[600];
+    if (uv_fs_realpath(NULL, &req, filename, NULL) != 0) {
+        uv_fs_req_cleanup(&req);
+        return 0;
+    }
+    snprintf(target, sizeof(target), "%s", (const char*)req.ptr);
+    uv_fs_req_cleanup(&req);
+    if (uv_fs_stat(NULL, &req, target, NULL) != 0) {
+        uv_fs_req_cleanup(&req);
+        return 0;
+    }
+    int mode = (int)(req.statbuf.st_mode & 07777);
+    uv_fs_req_cleanup(&req);
+
+    FILE* in = fopen(target, "rb");
+    if (!in) return 0;
+
+    char tmp_path[620];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.dx-tmp", target);
+    FILE* out = fopen(tmp_path, "wb");
+    if (!out) {
+        fclose(in);
+        return 0;
+    }
+
+    uint64_t parse_start = trace_begin();
+    uint64_t id_alloc_ns = 0;
+    size_t max_carry = stream_chunk_size;
+    size_t capacity = stream_chunk_size + max_carry + 1;
+    char* window = malloc(capacity);
+    CHECK(window);
+    StringBuilder sb;
+    sb_init(&sb, capacity + 4096);
+    TagPlan plan = {0};
+
+    size_t filled = 0, total = 0;
+    bool changed = false, eof = false, failed = false;
+    while (!eof) {
+        size_t n = fread(window + filled, 1, capacity - 1 - filled, in);
+        if (n == 0) eof = true;
+        total += n;
+        filled += n;
+        window[filled] = '\0';
+
+        size_t consumed = scan_tags(&plan, window, filled, eof);
+        apply_plan(&sb, window, &plan, used_ids_head, &id_alloc_ns);
+        if (!eof && filled - consumed > max_carry) {
+            // A single tag larger than the window is passed through untouched.
+            sb_append_n(&sb, window + consumed, filled - consumed);
+            consumed = filled;
+        }
+
+        if (sb.len != consumed || memcmp(sb.buffer, window, consumed) != 0) changed = true;
+        if (sb.len > 0 && fwrite(sb.buffer, 1, sb.len, out) != sb.len) failed = true;
+        sb.len = 0;
+
+        memmove(window, window + consumed, filled - consumed);
+        filled -= consumed;
+    }
+
+    fclose(in);
+    if (fclose(out) != 0) failed = true;
+    sb_free(&sb);
+    free(plan.edits);
+    free(window);
+
+    if (parse_start) {
+        uint64_t parse_ns = uv_hrtime() - parse_start;
+        trace_record(TRACE_PARSE, parse_start, parse_ns - id_alloc_ns, 1, total);
+        trace_record(TRACE_ID_ALLOC, parse_start, id_alloc_ns, 1, 0);
+    }
+
+    if (!failed && changed) {
+        failed = uv_fs_chmod(NULL, &req, tmp_path, mode, NULL) != 0;
+        uv_fs_req_cleanup(&req);
+    }
+    if (changed && !failed) {
+        uint64_t span = trace_begin();
+        uv_fs_rename(NULL, &req, tmp_path, target, NULL);
+        uv_fs_req_cleanup(&req);
+        trace_end(TRACE_REWRITE, span, 1, total);
+        return 1;
+    }
+    uv_fs_unlink(NULL, &req, tmp_path, NULL);
+    uv_fs_req_cleanup(&req);
+    return 0;
+}
+
+int parser_apply_plan(const char* filename, char** source, size_t* size, TagPlan* plan, UsedIdNode** used_ids_head) {
+    uint64_t apply_start = trace_begin();
+    uint64_t id_alloc_ns = 0;
+    StringBuilder sb;
+    sb_init(&sb, *size + 4096);
+    apply_plan(&sb, *source, plan, used_ids_head, &id_alloc_ns);
+    
+    if (apply_start) {
+        uint64_t parse_ns = plan->scan_ns + (uv_hrtime() - apply_start);
+        trace_record(TRACE_PARSE, plan->scan_start, parse_ns - id_alloc_ns, 1, *size);
+        trace_record(TRACE_ID_ALLOC, apply_start, id_alloc_ns, 1, 0);
+    }
+
+    if (sb.len == *size && strcmp(*source, sb.buffer) == 0) {
+        sb_free(&sb);
+        return 0;
+    }
+
+    uint64_t span = trace_begin();
+    write_file_fast(filename, sb.buffer, sb.len);
+    trace_end(TRACE_REWRITE, span, 1, sb.len);
+    free(*source);
+    *source = sb.buffer;
+    *size = sb.len;
+    return 1;
+}
+
+int process_buffer(const char* filename, char** source, size_t* size, UsedIdNode** used_ids_head) {
+    TagPlan* plan = parser_scan_buffer(*source, *size);
+    int changes_made = parser_apply_plan(filename, source, size, plan, used_ids_head);
+    tag_plan_free(plan);
+    return changes_made;
+}
+
+int process_file(const char* filename, UsedIdNode** used_ids_head) {
+    if (should_stream(filename)) return process_file_streamed(filename, used_ids_head);
+
+    size_t size;
+    char *source = map_file_read(filename, &size);
+    if (!source) return 0;
+
+    int changes_made = process_buffer(filename, &source, &size, used_ids_head);
+    free(source);
+    return changes_made;
+}
+
+static bool data_lists_contains(const char** items, size_t count, const char* interned) {
+    for (size_t i = 0; i < count; i++) {
+        if (items[i] == interned) return true;
+    }
+    return false;
+}
+
+static void append_unique(const char*** items, size_t* count, size_t* capacity, const char* interned) {
+    if (data_lists_contains(*items, *count, interned)) return;
+    if (*count >= *capacity) {
+        *capacity = *capacity == 0 ? 16 : *capacity * 2;
+        *items = realloc(*items, *capacity * sizeof(char*));
+        CHECK(*items);
+    }
+    (*items)[(*count)++] = interned;
+}
+
+void data_lists_add_class(DataLists* data, const char* class_name) {
+    append_unique(&data->class_names, &data->class_count, &data->class_capacity, intern_string(class_name));
+}
+
+void data_lists_add_id(DataLists* data, const char* id) {
+    append_unique(&data->injected_ids, &data->id_count, &data->id_capacity, intern_string(id));
+}
+
+void data_lists_merge(DataLists* dest, const DataLists* src) {
+    for (size_t i = 0; i < src->class_count; i++) {
+        append_unique(&dest->class_names, &dest->class_count, &dest->class_capacity, src->class_names[i]);
+    }
+    for (size_t i = 0; i < src->id_count; i++) {
+        append_unique(&dest->injected_ids, &dest->id_count, &dest->id_capacity, src->injected_ids[i]);
+    }
+}
+
+void data_lists_diff(const DataLists* previous, const DataLists* current, DataLists* added, DataLists* removed) {
+    memset(added, 0, sizeof(DataLists));
+    memset(removed, 0, sizeof(DataLists));
+
+    for (size_t i = 0; i < current->class_count; i++) {
+        if (!data_lists_contains(previous->class_names, previous->class_count, current->class_names[i])) {
+            append_unique(&added->class_names, &added->class_count, &added->class_capacity, current->class_names[i]);
+        }
+    }
+    for (size_t i = 0; i < previous->class_count; i++) {
+        if (!data_lists_contains(current->class_names, current->class_count, previous->class_names[i])) {
+            append_unique(&removed->class_names, &removed->class_count, &removed->class_capacity, previous->class_names[i]);
+        }
+    }
+    for (size_t i = 0; i < current->id_count; i++) {
+        if (!data_lists_contains(previous->injected_ids, previous->id_count, current->injected_ids[i])) {
+            append_unique(&added->injected_ids, &added->id_count, &added->id_capacity, current->injected_ids[i]);
+        }
+    }
+    for (size_t i = 0; i < previous->id_count; i++) {
+        if (!data_lists_contains(current->injected_ids, current->id_count, previous->injected_ids[i])) {
+            append_unique(&removed->injected_ids, &removed->id_count, &removed->id_capacity, previous->injected_ids[i]);
+        }
+    }
+}
+
+// Resume offsets of the className/id scans relative to the start of the next
+// chunk, so a quoted value that ended past the carry point is not rescanned.
+typedef struct {
+    size_t class_resume;
+    size_t id_resume;
+} CollectCursor;
+
+static size_t collect_region(DataLists* data, const char* source, size_t len, bool final, CollectCursor* state) {
+    size_t cut = len;
+    if (!final) {
+        cut = len > PATTERN_TAIL ? len - PATTERN_TAIL : 0;
+        const char* patterns[2] = { "className=\"", "id=\"" };
+        size_t resume[2] = { state->class_resume, state->id_resume };
+        for (int k = 0; k < 2; k++) {
+            const char* p = source + resume[k];
+            while ((p = strstr(p, patterns[k])) && (size_t)(p - source) < cut) {
+                const char* end = strchr(p + strlen(patterns[k]), '"');
+                if (!end) {
+                    cut = p - source;
+                    break;
+                }
+                p = end;
             }
         }
-        
-        if (id_ptr) {
-            const char* id_val_start = strchr(id_ptr, '"') + 1;
-            const char* id_val_end = strchr(id_val_start, '"');
-
-            if (!id_val_start || !id_val_end || id_val_end > tag_end) {
-                sb_append_n(&sb, tag_start, tag_end - tag_start + 1);
-            } else {
-                sb_append_n(&sb, tag_start, id_val_start - tag_start);
-                sb_append_str(&sb, final_id);
-                sb_append_n(&sb, id_val_end, tag_end - id_val_end + 1);
+    }
+
+    const char* limit = source + cut;
+    const char* cursor = source + state->class_resume;
+    const char* class_end = cursor;
+    while((cursor = strstr(cursor, "className=\"")) && cursor < limit) {
+        cursor += 11; // strlen("className=\"")
+        const char* end = strchr(cursor, '"');
+        if(!end) break;
+
+        char class_str_buffer[512];
+        if((size_t)(end - cursor) < sizeof(class_str_buffer)) {
+            strncpy(class_str_buffer, cursor, end - cursor);
+            class_str_buffer[end - cursor] = '\0';
+
+            char* token = strtok(class_str_buffer, " ");
+            while(token) {
+                data_lists_add_class(data, token);
+                token = strtok(NULL, " ");
             }
-        } else {
-            const char* injection_point = class_val_end + 1;
-            sb_append_n(&sb, tag_start, injection_point - tag_start);
-            char id_attr[576];
-            snprintf(id_attr, sizeof(id_attr), " id=\"%s\"", final_id);
-            sb_append_str(&sb, id_attr);
-            sb_append_n(&sb, injection_point, tag_end - injection_point + 1);
         }
+        cursor = class_end = end;
+    }
 
-        cursor = tag_end + 1;
+    cursor = source + state->id_resume;
+    const char* id_end = cursor;
+    while((cursor = strstr(cursor, "id=\"")) && cursor < limit) {
+        cursor += 4; // strlen("id=\"")
+        const char* end = strchr(cursor, '"');
+        if(!end) break;
+
+        size_t len = end - cursor;
+        char id_val[256];
+        if (len < sizeof(id_val)) {
+            strncpy(id_val, cursor, len);
+            id_val[len] = '\0';
+            if (is_dx_id(id_val)) {
+                data_lists_add_id(data, id_val);
+            }
+        }
+        cursor = id_end = end;
     }
-    
-    int changes_made = 0;
-    if (sb.len != size || strcmp(source, sb.buffer) != 0) {
-        write_file_fast(filename, sb.buffer, sb.len);
-        changes_made = 1;
+
+    state->class_resume = class_end > limit ? (size_t)(class_end - limit) : 0;
+    state->id_resume = id_end > limit ? (size_t)(id_end - limit) : 0;
+    return cut;
+}
+
+static void collect_file_data_streamed(DataLists* data, const char* path) {
+    FILE* in = fopen(path, "rb");
+    if (!in) return;
+
+    uint64_t span = trace_begin();
+    size_t max_carry = stream_chunk_size;
+    size_t capacity = stream_chunk_size + max_carry + 1;
+    char* window = malloc(capacity);
+    CHECK(window);
+
+    CollectCursor state = {0};
+    size_t filled = 0, total = 0;
+    bool eof = false;
+    while (!eof) {
+        size_t n = fread(window + filled, 1, capacity - 1 - filled, in);
+        if (n == 0) eof = true;
+        total += n;
+        filled += n;
+        window[filled] = '\0';
+
+        size_t consumed = collect_region(data, window, filled, eof, &state);
+        if (!eof && filled - consumed > max_carry) {
+            // An attribute value longer than the window is skipped.
+            consumed = filled;
+            state.class_resume = state.id_resume = 0;
+        }
+        memmove(window, window + consumed, filled - consumed);
+        filled -= consumed;
     }
-    
-    sb_free(&sb);
+
+    fclose(in);
+    free(window);
+    trace_end(TRACE_READ, span, 1, total);
+}
+
+void collect_file_data(DataLists* data, const char* path) {
+    if (should_stream(path)) {
+        collect_file_data_streamed(data, path);
+        return;
+    }
+
+    size_t size;
+    char* source = map_file_read(path, &size);
+    if(!source) return;
+
+    collect_buffer_data(data, source, size);
     free(source);
-    return changes_made;
 }
 
+void collect_buffer_data(DataLists* data, const char* source, size_t size) {
+    CollectCursor state = {0};
+    collect_region(data, source, size, true, &state);
+}
 
 void collect_data(DataLists* data, const char* directory) {
     memset(data, 0, sizeof(DataLists));
@@ -130,81 +545,7 @@ void collect_data(DataLists* data, const char* directory) {
         if (dirent.type == UV_DIRENT_FILE && strstr(dirent.name, ".tsx")) {
             char full_path[512];
             snprintf(full_path, sizeof(full_path), "%s/%s", directory, dirent.name);
-            
-            size_t size;
-            char* source = map_file_read(full_path, &size);
-            if(!source) continue;
-
-            const char* cursor = source;
-            while((cursor = strstr(cursor, "className=\""))) {
-                cursor += 11; // strlen("className=\"")
-                const char* end = strchr(cursor, '"');
-                if(!end) break;
-                
-                char class_str_buffer[512];
-                if(end - cursor < sizeof(class_str_buffer)) {
-                    strncpy(class_str_buffer, cursor, end - cursor);
-                    class_str_buffer[end - cursor] = '\0';
-                    
-                    char* token = strtok(class_str_buffer, " ");
-                    while(token) {
-                        bool found = false;
-                        for (size_t j = 0; j < data->class_count; j++) {
-                            if (strcmp(data->class_names[j], token) == 0) {
-                                found = true;
-                                break;
-                            }
-                        }
-
-                        if (!found) {
-                            if (data->class_count >= data->class_capacity) {
-                                data->class_capacity = data->class_capacity == 0 ? 16 : data->class_capacity * 2;
-                                data->class_names = realloc(data->class_names, data->class_capacity * sizeof(char*));
-                                CHECK(data->class_names);
-                            }
-                            data->class_names[data->class_count++] = strdup(token);
-                            CHECK(data->class_names[data->class_count - 1]);
-                        }
-                        token = strtok(NULL, " ");
-                    }
-                }
-                cursor = end;
-            }
-            
-            cursor = source;
-            while((cursor = strstr(cursor, "id=\""))) {
-                cursor += 4; // strlen("id=\"")
-                const char* end = strchr(cursor, '"');
-                if(!end) break;
-                
-                size_t len = end - cursor;
-                char id_val[256];
-                if (len < sizeof(id_val)) {
-                    strncpy(id_val, cursor, len);
-                    id_val[len] = '\0';
-                    if (is_dx_id(id_val)) {
-                        bool found = false;
-                        for (size_t k = 0; k < data->id_count; k++) {
-                            if (strcmp(data->injected_ids[k], id_val) == 0) {
-                                found = true;
-                                break;
-                            }
-                        }
-
-                        if (!found) {
-                            if (data->id_count >= data->id_capacity) {
-                                data->id_capacity = data->id_capacity == 0 ? 16 : data->id_capacity * 2;
-                                data->injected_ids = realloc(data->injected_ids, data->id_capacity * sizeof(char*));
-                                CHECK(data->injected_ids);
-                            }
-                            data->injected_ids[data->id_count++] = strdup(id_val);
-                            CHECK(data->injected_ids[data->id_count - 1]);
-                        }
-                    }
-                }
-                cursor = end;
-            }
-            free(source);
+            collect_file_data(data, full_path);
         }
     }
     uv_fs_req_cleanup(&scan_req);
@@ -212,8 +553,6 @@ void collect_data(DataLists* data, const char* directory) {
 
 void free_data_contents(DataLists* data) {
     if (!data) return;
-    for(size_t i = 0; i < data->class_count; i++) free(data->class_names[i]);
-    for(size_t i = 0; i < data->id_count; i++) free(data->injected_ids[i]);
     free(data->class_names);
     free(data->injected_ids);
     memset(data, 0, sizeof(DataLists));
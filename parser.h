@@ -3,8 +3,26 @@
 
 #include "common.h"
 
+typedef struct TagPlan TagPlan;
+
 int process_file(const char* filename, UsedIdNode** used_ids_head);
+// Rewrites an already-read, NUL-terminated `*source`. When the file changes,
+// `*source`/`*size` are replaced with the rewritten contents.
+int process_buffer(const char* filename, char** source, size_t* size, UsedIdNode** used_ids_head);
+// process_buffer in two halves: the scan only reads `source` and is safe to
+// run off the loop thread; applying allocates ids and must run in file order.
+TagPlan* parser_scan_buffer(const char* source, size_t size);
+int parser_apply_plan(const char* filename, char** source, size_t* size, TagPlan* plan, UsedIdNode** used_ids_head);
+void tag_plan_free(TagPlan* plan);
+void collect_file_data(DataLists* data, const char* path);
+void collect_buffer_data(DataLists* data, const char* source, size_t size);
 void collect_data(DataLists* data, const char* directory);
+void data_lists_add_class(DataLists* data, const char* class_name);
+void data_lists_add_id(DataLists* data, const char* id);
+void data_lists_merge(DataLists* dest, const DataLists* src);
+void data_lists_diff(const DataLists* previous, const DataLists* current, DataLists* added, DataLists* removed);
 void free_data_contents(DataLists* data);
+void parser_set_memory_budget(size_t budget_bytes);
+bool parser_streams_size(size_t size);
 
 #endif
\ No newline at end of file
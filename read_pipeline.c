@@ -0,0 +1,260 @@
+#include "read_pipeline.h"
+#include "trace.h"
+#include "parse_pool.h"
+
+// Files are read through uv_fs requests on a private loop, which libuv's
+// Linux backend turns into io_uring submissions when available. Up to
+// READ_PIPELINE_WINDOW open -> fstat -> read -> close chains are in flight;
+// file i uses slot i % WINDOW, so results are handed over in order and at
+// most a window's worth of buffers is held at once. Under a byte limit,
+// buffers are also allocated in file order once their size is known, and only
+// while the undelivered ones fit; the next file to deliver is always let in.
+// Read buffers go to the parse pool before being handed over.
+#define READ_PIPELINE_WINDOW 64
+
+typedef struct {
+    uv_fs_t req;
+    ParseJob job;
+    uv_file fd;
+    char* data;
+    size_t size;
+    size_t filled;
+    void* result;
+    bool sized;
+    bool admitted;
+    bool done;
+} ReadSlot;
+
+static uv_loop_t read_loop;
+static bool loop_ready = false;
+static bool pool_ready = false;
+static ReadSlot slots[READ_PIPELINE_WINDOW];
+static char** pending_paths;
+static size_t pending_count;
+static size_t next_submit;
+static size_t next_admit;
+static size_t next_deliver;
+static size_t byte_limit = 0;
+static size_t bytes_in_flight;
+static read_pipeline_skip_cb skip_size;
+static read_pipeline_work_cb work_cb;
+static read_pipeline_cb deliver_cb;
+static void* deliver_ctx;
+static bool pumping = false;
+static uint64_t deliver_ns;
+static size_t bytes_read;
+
+static void pump(void);
+
+#define SLOT_OF_JOB(j) ((ReadSlot*)((char*)(j) - offsetof(ReadSlot, job)))
+
+static void run_work(ParseJob* job) {
+    ReadSlot* slot = SLOT_OF_JOB(job);
+    slot->result = work_cb(slot->data, slot->filled);
+}
+
+static void on_work_done(ParseJob* job) {
+    SLOT_OF_JOB(job)->done = true;
+    pump();
+}
+
+static void finish(ReadSlot* slot) {
+    slot->admitted = true;
+    if (!slot->data || !work_cb) {
+        slot->done = true;
+        return;
+    }
+    slot->data[slot->filled] = '\0';
+    if (!pool_ready) {
+        slot->result = work_cb(slot->data, slot->filled);
+        slot->done = true;
+        return;
+    }
+    slot->job.work = run_work;
+    slot->job.done = on_work_done;
+    parse_pool_submit(&slot->job);
+}
+
+static void on_close(uv_fs_t* req) {
+    uv_fs_req_cleanup(req);
+    finish((ReadSlot*)req);
+    pump();
+}
+
+static void close_slot(ReadSlot* slot) {
+    if (uv_fs_close(&read_loop, &slot->req, slot->fd, on_close) != 0) {
+        uv_fs_t close_req;
+        uv_fs_close(NULL, &close_req, slot->fd, NULL);
+        uv_fs_req_cleanup(&close_req);
+        finish(slot);
+        pump();
+    }
+}
+
+static void drop_data(ReadSlot* slot) {
+    free(slot->data);
+    slot->data = NULL;
+    slot->filled = 0;
+}
+
+static void on_read(uv_fs_t* req) {
+    ReadSlot* slot = (ReadSlot*)req;
+    ssize_t result = req->result;
+    uv_fs_req_cleanup(req);
+
+    if (result < 0) {
+        drop_data(slot);
+    } else if (result > 0) {
+        slot->filled += (size_t)result;
+        if (slot->filled < slot->size) {
+            uv_buf_t buf = uv_buf_init(slot->data + slot->filled, (unsigned int)(slot->size - slot->filled));
+            if (uv_fs_read(&read_loop, req, slot->fd, &buf, 1, (int64_t)slot->filled, on_read) == 0) return;
+            drop_data(slot);
+        }
+    }
+    // A zero-byte read means the file shrank after fstat; keep what was read.
+    close_slot(slot);
+}
+
+static void start_read(ReadSlot* slot) {
+    slot->admitted = true;
+    bytes_in_flight += slot->size;
+    slot->data = malloc(slot->size + 1);
+    CHECK(slot->data);
+    if (slot->size > 0) {
+        uv_buf_t buf = uv_buf_init(slot->data, (unsigned int)slot->size);
+        if (uv_fs_read(&read_loop, &slot->req, slot->fd, &buf, 1, 0, on_read) == 0) return;
+        drop_data(slot);
+    }
+    close_slot(slot);
+}
+
+// Starts reads in file order for as long as their buffers fit the limit.
+static void admit(void) {
+    if (next_admit < next_deliver) next_admit = next_deliver;
+    while (next_admit < next_submit) {
+        ReadSlot* slot = &slots[next_admit % READ_PIPELINE_WINDOW];
+        if (!slot->admitted) {
+            if (!slot->sized) return;
+            if (byte_limit && bytes_in_flight > 0 && bytes_in_flight + slot->size > byte_limit) return;
+            start_read(slot);
+        }
+        next_admit++;
+    }
+}
+
+static void on_stat(uv_fs_t* req) {
+    ReadSlot* slot = (ReadSlot*)req;
+    bool ok = req->result == 0;
+    slot->size = ok ? (size_t)req->statbuf.st_size : 0;
+    uv_fs_req_cleanup(req);
+
+    if (ok && !(skip_size && skip_size(slot->size))) {
+        slot->sized = true;
+        pump();
+        return;
+    }
+    slot->admitted = true;
+    close_slot(slot);
+    pump();
+}
+
+static void on_open(uv_fs_t* req) {
+    ReadSlot* slot = (ReadSlot*)req;
+    ssize_t result = req->result;
+    uv_fs_req_cleanup(req);
+
+    if (result < 0) {
+        finish(slot);
+        pump();
+        return;
+    }
+    slot->fd = (uv_file)result;
+    if (uv_fs_fstat(&read_loop, req, slot->fd, on_stat) != 0) close_slot(slot);
+}
+
+static void submit(size_t index) {
+    ReadSlot* slot = &slots[index % READ_PIPELINE_WINDOW];
+    memset(slot, 0, sizeof(*slot));
+    if (uv_fs_open(&read_loop, &slot->req, pending_paths[index], UV_FS_O_RDONLY, 0, on_open) != 0) {
+        finish(slot);
+    }
+}
+
+// Hands finished files to the callback in order and refills the window.
+// Callbacks completing inside the callback re-enter here; the guard turns
+// that into another pass of the outer loop.
+static void pump(void) {
+    if (pumping) return;
+    pumping = true;
+    bool progress = true;
+    while (progress) {
+        progress = false;
+        while (next_deliver < pending_count && slots[next_deliver % READ_PIPELINE_WINDOW].done) {
+            ReadSlot* slot = &slots[next_deliver % READ_PIPELINE_WINDOW];
+            slot->done = false;
+            if (slot->sized) bytes_in_flight -= slot->size;
+            bytes_read += slot->filled;
+            uint64_t start = uv_hrtime();
+            deliver_cb(pending_paths[next_deliver], slot->data, slot->filled, slot->result, deliver_ctx);
+            deliver_ns += uv_hrtime() - start;
+            slot->data = NULL;
+            slot->result = NULL;
+            next_deliver++;
+            progress = true;
+        }
+        while (next_submit < pending_count && next_submit < next_deliver + READ_PIPELINE_WINDOW) {
+            submit(next_submit++);
+            progress = true;
+        }
+        size_t admitted = next_admit;
+        admit();
+        if (next_admit != admitted) progress = true;
+    }
+    pumping = false;
+}
+
+// run_modification_cycle is itself called from the main loop, which cannot
+// be re-entered, so the pipeline drives a loop of its own.
+void read_pipeline_run(char** paths, size_t count, read_pipeline_skip_cb skip, read_pipeline_work_cb work,
+                       read_pipeline_cb cb, void* ctx) {
+    if (count == 0) return;
+    if (!loop_ready) {
+        CHECK(uv_loop_init(&read_loop) == 0);
+        loop_ready = true;
+        // Without workers the work runs inline on the loop thread.
+        pool_ready = parse_pool_start(&read_loop, 0) == 0;
+    }
+
+    pending_paths = paths;
+    pending_count = count;
+    next_submit = next_admit = next_deliver = 0;
+    bytes_in_flight = 0;
+    skip_size = skip;
+    work_cb = work;
+    deliver_cb = cb;
+    deliver_ctx = ctx;
+    deliver_ns = 0;
+    bytes_read = 0;
+
+    // Time spent in the callback belongs to the parser's own phases.
+    uint64_t span = trace_begin();
+    pump();
+    uv_run(&read_loop, UV_RUN_DEFAULT);
+    if (span) trace_record(TRACE_READ, span, uv_hrtime() - span - deliver_ns, count, bytes_read);
+    pending_paths = NULL;
+    pending_count = 0;
+}
+
+void read_pipeline_set_byte_limit(size_t bytes) {
+    byte_limit = bytes;
+}
+
+void read_pipeline_shutdown(void) {
+    if (!loop_ready) return;
+    if (pool_ready) parse_pool_stop();
+    pool_ready = false;
+    uv_run(&read_loop, UV_RUN_DEFAULT);
+    uv_loop_close(&read_loop);
+    loop_ready = false;
+}
\ No newline at end of file
@@ -0,0 +1,22 @@
+#ifndef DX_READ_PIPELINE_H
+#define DX_READ_PIPELINE_H
+
+#include "common.h"
+
+// Receives each file in `paths` order. `source` is NUL-terminated and owned
+// by the callback; it is NULL when the file could not be read or `skip`
+// rejected its size, leaving the caller to handle that path itself.
+// `result` is what `work` returned for the buffer (NULL without a source).
+typedef void (*read_pipeline_cb)(const char* path, char* source, size_t size, void* result, void* ctx);
+typedef bool (*read_pipeline_skip_cb)(size_t size);
+// Runs on a parse pool worker as soon as a buffer is read, in any order.
+typedef void* (*read_pipeline_work_cb)(const char* source, size_t size);
+
+void read_pipeline_run(char** paths, size_t count, read_pipeline_skip_cb skip, read_pipeline_work_cb work,
+                       read_pipeline_cb cb, void* ctx);
+// Caps the bytes held in read buffers not yet handed to the callback; 0
+// leaves only the window's slot count as a limit.
+void read_pipeline_set_byte_limit(size_t bytes);
+void read_pipeline_shutdown(void);
+
+#endif
\ No newline at end of file
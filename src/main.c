@@ -1,9 +1,17 @@
 #define _POSIX_C_SOURCE 200809L
+#if defined(__linux__)
+    #define _GNU_SOURCE
+#endif
 #include <stdio.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
+#include "../diff_writer.h"
+
 #if defined(_WIN32)
     #define DX_PLATFORM_WINDOWS
 #elif defined(__unix__) || defined(__APPLE__)
@@ -27,6 +35,15 @@
         #define O_DIRECTORY 0200000
     #endif
     #define MKDIR(path) mkdir(path, 0755)
+    #if defined(__linux__) && defined(__has_include)
+        #if __has_include(<linux/io_uring.h>)
+            #define DX_HAVE_IO_URING
+            #include <errno.h>
+            #include <sys/syscall.h>
+            #include <sys/uio.h>
+            #include <linux/io_uring.h>
+        #endif
+    #endif
 #else
     #include <sys/stat.h>
     #include <threads.h>
@@ -36,6 +53,7 @@
 #define FOLDER "modules"
 #define FILE_PREFIX "file"
 #define FILE_SUFFIX ".txt"
+#define NUM_THREADS 8 // fallback when the core count cannot be queried
 
 static inline char* fast_itoa(int value, char* buffer_end) {
     *buffer_end = '\0';
@@ -51,61 +69,241 @@ double get_monotonic_time() {
     return (double)ts.tv_sec + (double)ts.tv_nsec / 1.0e9;
 }
 
+// Workers pull WORK_CHUNK files at a time from a shared cursor, so a thread
+// stuck on slow files simply claims fewer chunks instead of holding up a
+// fixed slice of the work.
+#define MAX_THREADS 256
+#define WORK_CHUNK 32
+
+typedef struct {
+    const int *indices;
+    int num_files;
+    atomic_int cursor;
+} WorkQueue;
+
+typedef struct {
+    int files;
+    int chunks;
+    int skipped;
+    int failures;
+    double active_ms;
+} WorkerStats;
+
+static void work_queue_init(WorkQueue *queue, const int *indices, int num_files) {
+    queue->indices = indices;
+    queue->num_files = num_files;
+    atomic_init(&queue->cursor, 0);
+}
+
+static bool claim_chunk(WorkQueue *queue, int *start, int *end) {
+    int first = atomic_fetch_add_explicit(&queue->cursor, WORK_CHUNK, memory_order_relaxed);
+    if (first >= queue->num_files) return false;
+    *start = first;
+    *end = queue->num_files - first > WORK_CHUNK ? first + WORK_CHUNK : queue->num_files;
+    return true;
+}
+
+static int default_thread_count(void) {
+#if defined(DX_PLATFORM_WINDOWS)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    long count = (long)info.dwNumberOfProcessors;
+#elif defined(DX_PLATFORM_POSIX)
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+#else
+    long count = NUM_THREADS;
+#endif
+    if (count < 1) count = 1;
+    if (count > MAX_THREADS) count = MAX_THREADS;
+    return (int)count;
+}
+
+static void print_worker_stats(const WorkerStats *stats, int thread_count) {
+    printf("\n%-8s %8s %8s %8s %8s %12s\n", "Thread", "Files", "Chunks", "Skipped", "Failed", "Active (ms)");
+    double fastest = 0, slowest = 0;
+    for (int i = 0; i < thread_count; i++) {
+        printf("%-8d %8d %8d %8d %8d %12.2f\n", i, stats[i].files, stats[i].chunks, stats[i].skipped,
+               stats[i].failures, stats[i].active_ms);
+        if (i == 0 || stats[i].active_ms < fastest) fastest = stats[i].active_ms;
+        if (stats[i].active_ms > slowest) slowest = stats[i].active_ms;
+    }
+    printf("Spread between first and last thread to finish: %.2f ms\n", slowest - fastest);
+}
+
+typedef enum {
+    SIZES_FIXED,
+    SIZES_REALISTIC
+} SizeProfile;
+
+#if defined(DX_PLATFORM_WINDOWS) || defined(DX_PLATFORM_POSIX)
+// What one pass writes: every file gets a prefix of `data`, either `len`
+// bytes or lengths[i] bytes for the i-th claimed index.
+typedef struct {
+    char *data;
+    size_t len;
+    size_t capacity;
+    size_t *lengths;
+    size_t total_bytes;
+} Payload;
+
+#define REALISTIC_MAX_SIZE (256 * 1024)
+
+static uint32_t mix32(uint32_t x) {
+    x ^= x >> 16; x *= 0x7feb352dU;
+    x ^= x >> 15; x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
+
+// Shaped after a front-end source tree: mostly small modules with a long
+// tail of generated or vendored files. Each pass uses its own seed, so a
+// rewrite grows some files and shrinks others.
+static size_t realistic_size(int index, uint32_t seed) {
+    uint32_t h = mix32((uint32_t)index * 0x9e3779b9U ^ seed);
+    uint32_t bucket = h % 100, r = h >> 8;
+    if (bucket < 50) return 512 + r % (4096 - 512);
+    if (bucket < 80) return 4096 + r % (16384 - 4096);
+    if (bucket < 95) return 16384 + r % (65536 - 16384);
+    return 65536 + r % (REALISTIC_MAX_SIZE - 65536);
+}
+
+static int payload_init(Payload *payload, const char *header, SizeProfile profile,
+                        const int *indices, int num_files, uint32_t seed) {
+    size_t header_len = strlen(header);
+    memset(payload, 0, sizeof(*payload));
+    payload->capacity = profile == SIZES_REALISTIC ? REALISTIC_MAX_SIZE : header_len;
+    payload->data = malloc(payload->capacity + 1);
+    if (!payload->data) return -1;
+
+    memcpy(payload->data, header, header_len);
+    static const char filler[] = ".dx-generated { display: flex; align-items: center; }\n";
+    for (size_t at = header_len; at < payload->capacity; at += sizeof(filler) - 1) {
+        size_t n = payload->capacity - at < sizeof(filler) - 1 ? payload->capacity - at : sizeof(filler) - 1;
+        memcpy(payload->data + at, filler, n);
+    }
+    payload->data[payload->capacity] = '\0';
+
+    if (profile == SIZES_FIXED) {
+        payload->len = header_len;
+        payload->total_bytes = header_len * (size_t)num_files;
+        return 0;
+    }
+    payload->lengths = malloc(num_files * sizeof(size_t));
+    if (!payload->lengths) {
+        free(payload->data);
+        return -1;
+    }
+    for (int i = 0; i < num_files; i++) {
+        payload->lengths[i] = realistic_size(indices[i], seed);
+        payload->total_bytes += payload->lengths[i];
+    }
+    return 0;
+}
+
+static void payload_free(Payload *payload) {
+    free(payload->data);
+    free(payload->lengths);
+}
+
+static inline size_t payload_len(const Payload *payload, int i) {
+    return payload->lengths ? payload->lengths[i] : payload->len;
+}
+
+// Below this size a rewrite goes through a plain positional write; mapping,
+// faulting in and unmapping the pages costs more than the copy it saves.
+#define MMAP_PWRITE_BELOW (64 * 1024)
+#endif
+
 #if defined(DX_PLATFORM_WINDOWS)
 #define CREATE_CONTENT "Files Created on Windows!\n"
 #define OVERWRITE_CONTENT "Files Overwritten with MMAP on Windows!\n"
 
 typedef struct {
-    const int *indices;
-    int start;
-    int end;
-    const char *content;
-    size_t content_len;
+    WorkQueue *queue;
+    WorkerStats stats;
+    const Payload *payload;
+    size_t pwrite_below;
 } ThreadArgs_Windows;
 
 int create_files_worker_windows(void* arg) {
     ThreadArgs_Windows *args = (ThreadArgs_Windows *)arg;
+    double started = get_monotonic_time();
     char filepath[256];
-    for (int i = args->start; i < args->end; ++i) {
-        snprintf(filepath, sizeof(filepath), "%s\\%s%d%s", FOLDER, FILE_PREFIX, args->indices[i], FILE_SUFFIX);
-        FILE *fp = fopen(filepath, "wb");
-        if (fp) {
-            fwrite(args->content, 1, args->content_len, fp);
-            fclose(fp);
+    int start, end;
+    while (claim_chunk(args->queue, &start, &end)) {
+        args->stats.chunks++;
+        for (int i = start; i < end; ++i) {
+            snprintf(filepath, sizeof(filepath), "%s\\%s%d%s", FOLDER, FILE_PREFIX, args->queue->indices[i], FILE_SUFFIX);
+            args->stats.files++;
+            size_t len = payload_len(args->payload, i);
+            FILE *fp = fopen(filepath, "wb");
+            if (fp) {
+                if (fwrite(args->payload->data, 1, len, fp) != len) args->stats.failures++;
+                fclose(fp);
+            } else {
+                args->stats.failures++;
+            }
         }
     }
+    args->stats.active_ms = (get_monotonic_time() - started) * 1000.0;
     return 0;
 }
 
+static bool truncate_file_windows(HANDLE hFile, size_t len) {
+    LARGE_INTEGER offset;
+    offset.QuadPart = (LONGLONG)len;
+    return SetFilePointerEx(hFile, offset, NULL, FILE_BEGIN) && SetEndOfFile(hFile);
+}
+
+// A mapping created larger than the file extends it, so growing needs no
+// separate step; shrinking has to wait until the view is gone.
+static bool rewrite_file_windows(HANDLE hFile, const char *content, size_t len, size_t pwrite_below) {
+    LARGE_INTEGER old_size;
+    if (!GetFileSizeEx(hFile, &old_size)) return false;
+
+    if (len == 0 || len < pwrite_below) {
+        DWORD written = 0;
+        if (len > 0 && (!WriteFile(hFile, content, (DWORD)len, &written, NULL) || written != len)) return false;
+        return (LONGLONG)len >= old_size.QuadPart || truncate_file_windows(hFile, len);
+    }
+
+    HANDLE hMapFile = CreateFileMappingA(hFile, NULL, PAGE_READWRITE, (DWORD)((uint64_t)len >> 32), (DWORD)len, NULL);
+    if (hMapFile == NULL) return false;
+    LPVOID pMapView = MapViewOfFile(hMapFile, FILE_MAP_WRITE, 0, 0, len);
+    if (pMapView == NULL) {
+        CloseHandle(hMapFile);
+        return false;
+    }
+    memcpy(pMapView, content, len);
+    UnmapViewOfFile(pMapView);
+    CloseHandle(hMapFile);
+    return (LONGLONG)len >= old_size.QuadPart || truncate_file_windows(hFile, len);
+}
+
 int overwrite_files_mmap_worker_windows(void *arg) {
     ThreadArgs_Windows *args = (ThreadArgs_Windows *)arg;
+    double started = get_monotonic_time();
     char filepath[256];
+    int start, end;
 
-    for (int i = args->start; i < args->end; i++) {
-        snprintf(filepath, sizeof(filepath), "%s\\%s%d%s", FOLDER, FILE_PREFIX, args->indices[i], FILE_SUFFIX);
-
-        HANDLE hFile = CreateFileA(filepath, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
-        if (hFile == INVALID_HANDLE_VALUE) continue;
+    while (claim_chunk(args->queue, &start, &end)) {
+        args->stats.chunks++;
+        for (int i = start; i < end; i++) {
+            snprintf(filepath, sizeof(filepath), "%s\\%s%d%s", FOLDER, FILE_PREFIX, args->queue->indices[i], FILE_SUFFIX);
+            args->stats.files++;
 
-        HANDLE hMapFile = CreateFileMappingA(hFile, NULL, PAGE_READWRITE, 0, (DWORD)args->content_len, NULL);
-        if (hMapFile == NULL) {
+            HANDLE hFile = CreateFileA(filepath, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+            if (hFile == INVALID_HANDLE_VALUE) {
+                args->stats.failures++;
+                continue;
+            }
+            if (!rewrite_file_windows(hFile, args->payload->data, payload_len(args->payload, i), args->pwrite_below)) {
+                args->stats.failures++;
+            }
             CloseHandle(hFile);
-            continue;
         }
-
-        LPVOID pMapView = MapViewOfFile(hMapFile, FILE_MAP_WRITE, 0, 0, args->content_len);
-        if (pMapView == NULL) {
-            CloseHandle(hMapFile);
-            CloseHandle(hFile);
-            continue;
-        }
-
-        memcpy(pMapView, args->content, args->content_len);
-
-        UnmapViewOfFile(pMapView);
-        CloseHandle(hMapFile);
-        CloseHandle(hFile);
     }
+    args->stats.active_ms = (get_monotonic_time() - started) * 1000.0;
     return 0;
 }
 #endif
@@ -115,105 +313,524 @@ int overwrite_files_mmap_worker_windows(void *arg) {
 #define OVERWRITE_CONTENT "Files Overwritten with MMAP on POSIX!\n"
 
 typedef struct {
-    const int *indices;
-    int start;
-    int end;
+    WorkQueue *queue;
+    WorkerStats stats;
     int dir_fd;
-    const char *content;
-    size_t content_len;
+    const Payload *payload;
+    size_t pwrite_below;
 } ThreadArgs_POSIX;
 
 void *create_files_worker_posix(void *arg) {
     ThreadArgs_POSIX *args = (ThreadArgs_POSIX *)arg;
+    double started = get_monotonic_time();
     char filename[256];
     const size_t prefix_len = strlen(FILE_PREFIX);
     const size_t suffix_len = strlen(FILE_SUFFIX);
     memcpy(filename, FILE_PREFIX, prefix_len);
     char *num_start_ptr = filename + prefix_len;
+    int start, end;
 
-    for (int i = args->start; i < args->end; i++) {
-        char num_buf[12];
-        char* num_str = fast_itoa(args->indices[i], num_buf + sizeof(num_buf) - 1);
-        size_t num_len = (num_buf + sizeof(num_buf) - 1) - num_str;
-        memcpy(num_start_ptr, num_str, num_len);
-        memcpy(num_start_ptr + num_len, FILE_SUFFIX, suffix_len + 1);
+    while (claim_chunk(args->queue, &start, &end)) {
+        args->stats.chunks++;
+        for (int i = start; i < end; i++) {
+            char num_buf[12];
+            char* num_str = fast_itoa(args->queue->indices[i], num_buf + sizeof(num_buf) - 1);
+            size_t num_len = (num_buf + sizeof(num_buf) - 1) - num_str;
+            memcpy(num_start_ptr, num_str, num_len);
+            memcpy(num_start_ptr + num_len, FILE_SUFFIX, suffix_len + 1);
+            args->stats.files++;
 
-        int fd = openat(args->dir_fd, filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
-        if (fd == -1) continue;
-        write(fd, args->content, args->content_len);
-        close(fd);
+            int fd = openat(args->dir_fd, filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (fd == -1) {
+                args->stats.failures++;
+                continue;
+            }
+            size_t len = payload_len(args->payload, i);
+            if (write(fd, args->payload->data, len) != (ssize_t)len) args->stats.failures++;
+            close(fd);
+        }
     }
+    args->stats.active_ms = (get_monotonic_time() - started) * 1000.0;
     return NULL;
 }
 
+static int rewrite_file_posix(int fd, const char *content, size_t len, size_t pwrite_below) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) return -1;
+    off_t old_size = st.st_size;
+
+    if (len == 0 || len < pwrite_below) {
+        if (pwrite(fd, content, len, 0) != (ssize_t)len) return -1;
+        return (off_t)len < old_size ? ftruncate(fd, (off_t)len) : 0;
+    }
+
+    // Touching a mapped page past EOF raises SIGBUS, so the file reaches its
+    // new size before it is mapped. fallocate also reserves the blocks, which
+    // turns a full disk into an error here rather than a fault in memcpy.
+    if ((off_t)len > old_size) {
+#if defined(__linux__)
+        if (fallocate(fd, 0, 0, (off_t)len) != 0 && ftruncate(fd, (off_t)len) != 0) return -1;
+#else
+        if (ftruncate(fd, (off_t)len) != 0) return -1;
+#endif
+    } else if ((off_t)len < old_size && ftruncate(fd, (off_t)len) != 0) {
+        return -1;
+    }
+
+    void *map = mmap(NULL, len, PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) return -1;
+    memcpy(map, content, len);
+    munmap(map, len);
+    return 0;
+}
+
 void *overwrite_files_mmap_worker_posix(void *arg) {
     ThreadArgs_POSIX *args = (ThreadArgs_POSIX *)arg;
+    double started = get_monotonic_time();
     char filename[256];
     const size_t prefix_len = strlen(FILE_PREFIX);
     const size_t suffix_len = strlen(FILE_SUFFIX);
     memcpy(filename, FILE_PREFIX, prefix_len);
     char *num_start_ptr = filename + prefix_len;
+    int start, end;
 
-    for (int i = args->start; i < args->end; i++) {
-        char num_buf[12];
-        char* num_str = fast_itoa(args->indices[i], num_buf + sizeof(num_buf) - 1);
-        size_t num_len = (num_buf + sizeof(num_buf) - 1) - num_str;
-        memcpy(num_start_ptr, num_str, num_len);
-        memcpy(num_start_ptr + num_len, FILE_SUFFIX, suffix_len + 1);
-
-        int fd = openat(args->dir_fd, filename, O_RDWR);
-        if (fd == -1) continue;
+    while (claim_chunk(args->queue, &start, &end)) {
+        args->stats.chunks++;
+        for (int i = start; i < end; i++) {
+            char num_buf[12];
+            char* num_str = fast_itoa(args->queue->indices[i], num_buf + sizeof(num_buf) - 1);
+            size_t num_len = (num_buf + sizeof(num_buf) - 1) - num_str;
+            memcpy(num_start_ptr, num_str, num_len);
+            memcpy(num_start_ptr + num_len, FILE_SUFFIX, suffix_len + 1);
+            args->stats.files++;
 
-        void *map = mmap(NULL, args->content_len, PROT_WRITE, MAP_SHARED, fd, 0);
-        if (map == MAP_FAILED) {
+            int fd = openat(args->dir_fd, filename, O_RDWR);
+            if (fd == -1) {
+                args->stats.failures++;
+                continue;
+            }
+            if (rewrite_file_posix(fd, args->payload->data, payload_len(args->payload, i), args->pwrite_below) != 0) {
+                args->stats.failures++;
+            }
             close(fd);
-            continue;
         }
-        memcpy(map, args->content, args->content_len);
-        munmap(map, args->content_len);
-        close(fd);
     }
+    args->stats.active_ms = (get_monotonic_time() - started) * 1000.0;
     return NULL;
 }
+
+void *diff_files_worker_posix(void *arg) {
+    ThreadArgs_POSIX *args = (ThreadArgs_POSIX *)arg;
+    double started = get_monotonic_time();
+    char filename[256];
+    const size_t prefix_len = strlen(FILE_PREFIX);
+    const size_t suffix_len = strlen(FILE_SUFFIX);
+    memcpy(filename, FILE_PREFIX, prefix_len);
+    char *num_start_ptr = filename + prefix_len;
+    int start, end;
+
+    while (claim_chunk(args->queue, &start, &end)) {
+        args->stats.chunks++;
+        for (int i = start; i < end; i++) {
+            char num_buf[12];
+            char* num_str = fast_itoa(args->queue->indices[i], num_buf + sizeof(num_buf) - 1);
+            size_t num_len = (num_buf + sizeof(num_buf) - 1) - num_str;
+            memcpy(num_start_ptr, num_str, num_len);
+            memcpy(num_start_ptr + num_len, FILE_SUFFIX, suffix_len + 1);
+            args->stats.files++;
+
+            DiffWriteResult r = diff_write_file_at(args->dir_fd, filename, args->payload->data,
+                                                   payload_len(args->payload, i), NULL);
+            if (r == DIFF_WRITE_SKIPPED) args->stats.skipped++;
+            else if (r == DIFF_WRITE_FAILED) args->stats.failures++;
+        }
+    }
+    args->stats.active_ms = (get_monotonic_time() - started) * 1000.0;
+    return NULL;
+}
+#endif
+
+#if defined(DX_PLATFORM_POSIX)
+static double elapsed_ms(const struct timespec *start) {
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start->tv_sec) * 1000.0 + (end.tv_nsec - start->tv_nsec) / 1000000.0;
+}
+
+static double run_posix_workers(void *(*worker_func)(void *), int dir_fd, const int *indices, int num_files,
+                                const Payload *payload, size_t pwrite_below, int thread_count, WorkerStats *stats) {
+    struct timespec start_time;
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+    WorkQueue queue;
+    work_queue_init(&queue, indices, num_files);
+    pthread_t threads[MAX_THREADS];
+    ThreadArgs_POSIX args[MAX_THREADS];
+    for (int i = 0; i < thread_count; i++) {
+        memset(&args[i], 0, sizeof(args[i]));
+        args[i].queue = &queue;
+        args[i].dir_fd = dir_fd;
+        args[i].payload = payload;
+        args[i].pwrite_below = pwrite_below;
+        pthread_create(&threads[i], NULL, worker_func, &args[i]);
+    }
+
+    for (int i = 0; i < thread_count; i++) {
+        pthread_join(threads[i], NULL);
+        if (stats) stats[i] = args[i].stats;
+    }
+    return elapsed_ms(&start_time);
+}
+#endif
+
+#if defined(DX_HAVE_IO_URING)
+// Each file is one linked OPENAT -> WRITE -> CLOSE chain. The open installs
+// straight into a slot of a registered (sparse) file table, which is what lets
+// the write and close in the same chain refer to a descriptor that does not
+// exist yet. Slots are recycled as their CLOSE completes, so the ring stays
+// full instead of draining between batches.
+#define URING_ENTRIES 4096
+#define URING_SLOTS (URING_ENTRIES / 3)
+
+typedef struct {
+    int fd;
+    unsigned sq_entries;
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sq_ring, *cq_ring;
+    size_t sq_ring_len, cq_ring_len, sqes_len;
+    unsigned sq_local_tail;
+} UringRing;
+
+static int uring_setup(UringRing *ring, unsigned entries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    memset(ring, 0, sizeof(*ring));
+
+    ring->fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (ring->fd < 0) return -errno;
+
+    ring->sq_ring_len = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_ring_len = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+        if (ring->cq_ring_len > ring->sq_ring_len) ring->sq_ring_len = ring->cq_ring_len;
+        ring->cq_ring_len = ring->sq_ring_len;
+    }
+
+    ring->sq_ring = mmap(NULL, ring->sq_ring_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         ring->fd, IORING_OFF_SQ_RING);
+    ring->cq_ring = single_mmap ? ring->sq_ring
+                                : mmap(NULL, ring->cq_ring_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                       ring->fd, IORING_OFF_CQ_RING);
+    ring->sqes_len = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring->fd, IORING_OFF_SQES);
+    if (ring->sq_ring == MAP_FAILED || ring->cq_ring == MAP_FAILED || ring->sqes == MAP_FAILED) {
+        close(ring->fd);
+        return -ENOMEM;
+    }
+
+    char *sq = ring->sq_ring, *cq = ring->cq_ring;
+    ring->sq_entries = params.sq_entries;
+    ring->sq_head = (unsigned *)(sq + params.sq_off.head);
+    ring->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+    ring->sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned *)(sq + params.sq_off.array);
+    ring->cq_head = (unsigned *)(cq + params.cq_off.head);
+    ring->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+    ring->cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+    ring->sq_local_tail = *ring->sq_tail;
+    return 0;
+}
+
+static void uring_teardown(UringRing *ring) {
+    munmap(ring->sqes, ring->sqes_len);
+    if (ring->cq_ring != ring->sq_ring) munmap(ring->cq_ring, ring->cq_ring_len);
+    munmap(ring->sq_ring, ring->sq_ring_len);
+    close(ring->fd);
+}
+
+static struct io_uring_sqe *uring_get_sqe(UringRing *ring) {
+    unsigned head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    if (ring->sq_local_tail - head >= ring->sq_entries) return NULL;
+    unsigned index = ring->sq_local_tail++ & *ring->sq_mask;
+    ring->sq_array[index] = index;
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+static int uring_register(UringRing *ring, unsigned opcode, const void *arg, unsigned count) {
+    return syscall(__NR_io_uring_register, ring->fd, opcode, arg, count) < 0 ? -errno : 0;
+}
+
+typedef struct {
+    int pending;
+    bool written;
+    size_t len;
+    char name[32];
+} UringSlot;
+
+static void uring_prep_chain(UringRing *ring, int dir_fd, unsigned slot, const char *name,
+                             const char *content, size_t content_len, bool fixed_buffer) {
+    struct io_uring_sqe *sqe = uring_get_sqe(ring);
+    sqe->opcode = IORING_OP_OPENAT;
+    sqe->fd = dir_fd;
+    sqe->addr = (uint64_t)(uintptr_t)name;
+    sqe->len = 0644;
+    sqe->open_flags = O_WRONLY | O_CREAT | O_TRUNC;
+    sqe->file_index = slot + 1;
+    sqe->flags = IOSQE_IO_LINK;
+    sqe->user_data = (uint64_t)slot << 2 | 0;
+
+    sqe = uring_get_sqe(ring);
+    sqe->opcode = fixed_buffer ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+    sqe->fd = (int)slot;
+    sqe->addr = (uint64_t)(uintptr_t)content;
+    sqe->len = (unsigned)content_len;
+    sqe->buf_index = 0;
+    // A hard link still closes the slot when the write fails or comes up short.
+    sqe->flags = IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK;
+    sqe->user_data = (uint64_t)slot << 2 | 1;
+
+    sqe = uring_get_sqe(ring);
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->file_index = slot + 1;
+    sqe->user_data = (uint64_t)slot << 2 | 2;
+}
+
+// Returns the elapsed time in ms, or a negative errno when the kernel lacks
+// what the chains need (direct descriptors arrived in 5.15).
+static double run_uring_generator(int dir_fd, const int *indices, int num_files,
+                                  const Payload *payload, bool fixed_buffer, int *written) {
+    struct timespec start_time;
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+    *written = 0;
+
+    UringRing ring;
+    int r = uring_setup(&ring, URING_ENTRIES);
+    if (r < 0) return r;
+
+    UringSlot *slots = calloc(URING_SLOTS, sizeof(UringSlot));
+    unsigned *free_slots = malloc(URING_SLOTS * sizeof(unsigned));
+    int *sparse = malloc(URING_SLOTS * sizeof(int));
+    if (!slots || !free_slots || !sparse) {
+        free(slots); free(free_slots); free(sparse);
+        uring_teardown(&ring);
+        return -ENOMEM;
+    }
+    for (unsigned i = 0; i < URING_SLOTS; i++) {
+        free_slots[i] = URING_SLOTS - 1 - i;
+        sparse[i] = -1;
+    }
+    unsigned free_count = URING_SLOTS;
+
+    r = uring_register(&ring, IORING_REGISTER_FILES, sparse, URING_SLOTS);
+    struct iovec iov = { .iov_base = payload->data, .iov_len = payload->capacity };
+    if (r == 0 && fixed_buffer) r = uring_register(&ring, IORING_REGISTER_BUFFERS, &iov, 1);
+    if (r < 0) {
+        free(slots); free(free_slots); free(sparse);
+        uring_teardown(&ring);
+        return r;
+    }
+
+    int next = 0, completed = 0;
+    unsigned in_flight_cqes = 0;
+    while (completed < num_files) {
+        unsigned to_submit = 0;
+        while (next < num_files && free_count > 0 && ring.sq_local_tail - *ring.sq_head + 3 <= ring.sq_entries) {
+            unsigned slot = free_slots[--free_count];
+            UringSlot *s = &slots[slot];
+            snprintf(s->name, sizeof(s->name), "%s%d%s", FILE_PREFIX, indices[next], FILE_SUFFIX);
+            s->pending = 3;
+            s->written = false;
+            s->len = payload_len(payload, next++);
+            uring_prep_chain(&ring, dir_fd, slot, s->name, payload->data, s->len, fixed_buffer);
+            to_submit += 3;
+        }
+        __atomic_store_n(ring.sq_tail, ring.sq_local_tail, __ATOMIC_RELEASE);
+        in_flight_cqes += to_submit;
+
+        unsigned wait_for = in_flight_cqes / 2 > 0 ? in_flight_cqes / 2 : 1;
+        if (syscall(__NR_io_uring_enter, ring.fd, to_submit, wait_for, IORING_ENTER_GETEVENTS, NULL, 0) < 0 &&
+            errno != EINTR) {
+            r = -errno;
+            break;
+        }
+
+        unsigned head = *ring.cq_head;
+        unsigned tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; head++) {
+            struct io_uring_cqe *cqe = &ring.cqes[head & *ring.cq_mask];
+            unsigned slot = (unsigned)(cqe->user_data >> 2);
+            if ((cqe->user_data & 3) == 1 && cqe->res == (int)slots[slot].len) slots[slot].written = true;
+            in_flight_cqes--;
+            if (--slots[slot].pending == 0) {
+                if (slots[slot].written) (*written)++;
+                free_slots[free_count++] = slot;
+                completed++;
+            }
+        }
+        __atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+    }
+
+    free(slots);
+    free(free_slots);
+    free(sparse);
+    uring_teardown(&ring);
+    return r < 0 ? r : elapsed_ms(&start_time);
+}
 #endif
 
 #if defined(DX_PLATFORM_STANDARD)
 #define CONTENT "Hello, Standard C I/O!"
 typedef struct {
-    const int *indices;
-    int start;
-    int end;
+    WorkQueue *queue;
+    WorkerStats stats;
 } ThreadData_Standard;
 
 int create_files_worker_standard(void* arg) {
     ThreadData_Standard *data = (ThreadData_Standard *)arg;
+    double started = get_monotonic_time();
     char filepath[256];
-    for (int i = data->start; i < data->end; ++i) {
-        snprintf(filepath, sizeof(filepath), "%s/%s%d%s", FOLDER, FILE_PREFIX, data->indices[i], FILE_SUFFIX);
-        FILE *fp = fopen(filepath, "w");
-        if (fp) {
-            fputs(CONTENT, fp);
-            fclose(fp);
+    int start, end;
+    while (claim_chunk(data->queue, &start, &end)) {
+        data->stats.chunks++;
+        for (int i = start; i < end; ++i) {
+            snprintf(filepath, sizeof(filepath), "%s/%s%d%s", FOLDER, FILE_PREFIX, data->queue->indices[i], FILE_SUFFIX);
+            data->stats.files++;
+            FILE *fp = fopen(filepath, "w");
+            if (fp) {
+                fputs(CONTENT, fp);
+                fclose(fp);
+            } else {
+                data->stats.failures++;
+            }
         }
     }
+    data->stats.active_ms = (get_monotonic_time() - started) * 1000.0;
     return 0;
 }
 #endif
 
-int run_file_generator(const int *indices, int num_files) {
+typedef enum {
+    GENERATOR_AUTO,
+    GENERATOR_IO_URING,
+    GENERATOR_IO_URING_FIXED,
+    GENERATOR_DIFF,
+    GENERATOR_COMPARE
+} GeneratorMode;
+
+#if defined(DX_PLATFORM_POSIX)
+static void print_throughput(const char *label, int files, size_t bytes, double ms) {
+    double seconds = ms / 1000.0;
+    printf("%-30s %8d %12.2f %12.0f %10.2f\n", label, files, ms, files / seconds,
+           (double)bytes / seconds / (1024.0 * 1024.0));
+}
+
+static int count_written(const WorkerStats *stats, int thread_count, int num_files) {
+    for (int i = 0; i < thread_count; i++) num_files -= stats[i].failures;
+    return num_files;
+}
+
+// Every rewrite strategy starts from the same freshly created tree, so each
+// one sees the same mix of files that grow and files that shrink.
+static void compare_strategies(int dir_fd, const int *indices, int num_files, const Payload *create,
+                               const Payload *rewrite, int thread_count) {
+    int grow = 0, shrink = 0;
+    for (int i = 0; i < num_files; i++) {
+        size_t before = payload_len(create, i), after = payload_len(rewrite, i);
+        if (after > before) grow++;
+        else if (after < before) shrink++;
+    }
+    printf("Running on POSIX: Comparing file emission strategies (%d threads).\n", thread_count);
+    printf("Rewrite pass: %.2f MB over %d files, %d grow, %d shrink.\n\n",
+           rewrite->total_bytes / (1024.0 * 1024.0), num_files, grow, shrink);
+    printf("%-30s %8s %12s %12s %10s\n", "Strategy", "Files", "Time (ms)", "Files/s", "MB/s");
+
+    WorkerStats stats[MAX_THREADS];
+    double ms = run_posix_workers(create_files_worker_posix, dir_fd, indices, num_files, create, 0,
+                                  thread_count, stats);
+    print_throughput("write (create)", count_written(stats, thread_count, num_files), create->total_bytes, ms);
+
+    char hybrid_label[64];
+    snprintf(hybrid_label, sizeof(hybrid_label), "mmap, pwrite below %d KiB", MMAP_PWRITE_BELOW / 1024);
+    const struct {
+        const char *label;
+        void *(*worker_func)(void *);
+        size_t pwrite_below;
+    } strategies[] = {
+        { "write (rewrite)", create_files_worker_posix, 0 },
+        { "mmap (rewrite)", overwrite_files_mmap_worker_posix, 0 },
+        { hybrid_label, overwrite_files_mmap_worker_posix, MMAP_PWRITE_BELOW },
+        { "diff writer (rewrite)", diff_files_worker_posix, 0 },
+    };
+    for (size_t s = 0; s < sizeof(strategies) / sizeof(strategies[0]); s++) {
+        run_posix_workers(create_files_worker_posix, dir_fd, indices, num_files, create, 0, thread_count, NULL);
+        ms = run_posix_workers(strategies[s].worker_func, dir_fd, indices, num_files, rewrite,
+                               strategies[s].pwrite_below, thread_count, stats);
+        print_throughput(strategies[s].label, count_written(stats, thread_count, num_files), rewrite->total_bytes, ms);
+    }
+
+    // The tree still holds the create pass, so nothing here needs writing.
+    run_posix_workers(create_files_worker_posix, dir_fd, indices, num_files, create, 0, thread_count, NULL);
+    ms = run_posix_workers(diff_files_worker_posix, dir_fd, indices, num_files, create, 0, thread_count, stats);
+    print_throughput("diff writer (unchanged)", count_written(stats, thread_count, num_files), create->total_bytes, ms);
+
+#if defined(DX_HAVE_IO_URING)
+    for (int fixed = 0; fixed <= 1; fixed++) {
+        const char *label = fixed ? "io_uring + fixed buffer" : "io_uring (rewrite)";
+        run_posix_workers(create_files_worker_posix, dir_fd, indices, num_files, create, 0, thread_count, NULL);
+        int written;
+        ms = run_uring_generator(dir_fd, indices, num_files, rewrite, fixed, &written);
+        if (ms < 0) {
+            printf("%-30s unavailable: %s\n", label, strerror((int)-ms));
+            continue;
+        }
+        print_throughput(label, written, rewrite->total_bytes, ms);
+    }
+#else
+    printf("%-30s unavailable on this platform\n", "io_uring");
+#endif
+}
+#endif
+
+int run_file_generator(const int *indices, int num_files, GeneratorMode mode, SizeProfile sizes, int thread_count) {
     if (num_files <= 0) {
         printf("No files to create.\n");
         return 0;
     }
 
-    #define NUM_THREADS 8
-    
     if (MKDIR(FOLDER) != 0) {
         printf("Directory '%s' may already exist. Continuing...\n", FOLDER);
     } else {
         printf("Directory '%s' created successfully.\n", FOLDER);
     }
 
+#if !defined(DX_PLATFORM_POSIX)
+    if (mode != GENERATOR_AUTO) {
+        fprintf(stderr, "Only the default strategy is available on this platform.\n");
+        return 1;
+    }
+#endif
+#if defined(DX_PLATFORM_WINDOWS) || defined(DX_PLATFORM_POSIX)
+    Payload create_payload, overwrite_payload;
+    if (payload_init(&create_payload, CREATE_CONTENT, sizes, indices, num_files, 1) != 0) {
+        perror("Failed to allocate file contents");
+        return 1;
+    }
+    if (payload_init(&overwrite_payload, OVERWRITE_CONTENT, sizes, indices, num_files, 2) != 0) {
+        perror("Failed to allocate file contents");
+        payload_free(&create_payload);
+        return 1;
+    }
+    int result = 0;
+#endif
+
 #if defined(DX_PLATFORM_WINDOWS)
     printf("Running on Windows: Using high-performance MMAP method.\n");
     double start_time = get_monotonic_time();
@@ -223,151 +840,196 @@ int run_file_generator(const int *indices, int num_files) {
     
     int (*worker_func)(void*);
     const char* action_description;
-    const char* content_to_write;
-
-    const size_t create_len = strlen(CREATE_CONTENT);
-    const size_t overwrite_len = strlen(OVERWRITE_CONTENT);
-    const size_t max_len = (create_len > overwrite_len) ? create_len : overwrite_len;
-    char padded_create_content[max_len + 1];
-    char padded_overwrite_content[max_len + 1];
-    memcpy(padded_create_content, CREATE_CONTENT, create_len);
-    memset(padded_create_content + create_len, ' ', max_len - create_len);
-    padded_create_content[max_len] = '\0';
-    memcpy(padded_overwrite_content, OVERWRITE_CONTENT, overwrite_len);
-    memset(padded_overwrite_content + overwrite_len, ' ', max_len - overwrite_len);
-    padded_overwrite_content[max_len] = '\0';
+    const Payload* payload;
 
     FILE* check_file = fopen(first_filepath, "r");
     if (check_file) {
         fclose(check_file);
         worker_func = overwrite_files_mmap_worker_windows;
-        content_to_write = padded_overwrite_content;
+        payload = &overwrite_payload;
         action_description = "overwriting";
     } else {
         worker_func = create_files_worker_windows;
-        content_to_write = padded_create_content;
+        payload = &create_payload;
         action_description = "creating";
     }
 
-    thrd_t threads[NUM_THREADS];
-    ThreadArgs_Windows args[NUM_THREADS];
-    int files_per_thread = num_files / NUM_THREADS;
+    WorkQueue queue;
+    work_queue_init(&queue, indices, num_files);
+    thrd_t threads[MAX_THREADS];
+    ThreadArgs_Windows args[MAX_THREADS];
+    WorkerStats stats[MAX_THREADS];
 
-    for (int i = 0; i < NUM_THREADS; i++) {
-        args[i].indices = indices;
-        args[i].start = i * files_per_thread;
-        args[i].end = (i == NUM_THREADS - 1) ? num_files : (i + 1) * files_per_thread;
-        args[i].content = content_to_write;
-        args[i].content_len = max_len;
+    for (int i = 0; i < thread_count; i++) {
+        memset(&args[i], 0, sizeof(args[i]));
+        args[i].queue = &queue;
+        args[i].payload = payload;
+        args[i].pwrite_below = MMAP_PWRITE_BELOW;
         thrd_create(&threads[i], worker_func, &args[i]);
     }
 
-    for (int i = 0; i < NUM_THREADS; i++) {
+    for (int i = 0; i < thread_count; i++) {
         thrd_join(threads[i], NULL);
+        stats[i] = args[i].stats;
     }
 
     double end_time = get_monotonic_time();
     double time_ms = (end_time - start_time) * 1000.0;
-    printf("\nFinished %s %d files.\n", action_description, num_files);
+    printf("\nFinished %s %d files on %d threads.\n", action_description, num_files, thread_count);
     printf("Total time taken: %.2f ms\n", time_ms);
+    print_worker_stats(stats, thread_count);
 
 #elif defined(DX_PLATFORM_POSIX)
-    printf("Running on POSIX: Using high-performance mmap/openat methods.\n");
-    struct timespec start_time, end_time;
-    clock_gettime(CLOCK_MONOTONIC, &start_time);
-
     int dir_fd = open(FOLDER, O_RDONLY | O_DIRECTORY);
     if (dir_fd == -1) {
         perror("Fatal: Could not open directory " FOLDER);
+        payload_free(&create_payload);
+        payload_free(&overwrite_payload);
         return 1;
     }
 
-    void *(*worker_func)(void *);
-    const char *content_to_write;
-    const char *action_description;
-    
-    const size_t create_len = strlen(CREATE_CONTENT);
-    const size_t overwrite_len = strlen(OVERWRITE_CONTENT);
-    const size_t max_len = (create_len > overwrite_len) ? create_len : overwrite_len;
-    char padded_create_content[max_len + 1];
-    char padded_overwrite_content[max_len + 1];
-    memcpy(padded_create_content, CREATE_CONTENT, create_len);
-    memset(padded_create_content + create_len, ' ', max_len - create_len);
-    padded_create_content[max_len] = '\0';
-    memcpy(padded_overwrite_content, OVERWRITE_CONTENT, overwrite_len);
-    memset(padded_overwrite_content + overwrite_len, ' ', max_len - overwrite_len);
-    padded_overwrite_content[max_len] = '\0';
-
-    char first_filename[64];
-    snprintf(first_filename, sizeof(first_filename), "%s%d%s", FILE_PREFIX, indices[0], FILE_SUFFIX);
-    if (faccessat(dir_fd, first_filename, F_OK, 0) == 0) {
-        worker_func = overwrite_files_mmap_worker_posix;
-        content_to_write = padded_overwrite_content;
-        action_description = "overwriting";
+    if (mode == GENERATOR_COMPARE) {
+        compare_strategies(dir_fd, indices, num_files, &create_payload, &overwrite_payload, thread_count);
+    } else if (mode == GENERATOR_DIFF) {
+        printf("Running on POSIX: Writing only files whose contents changed.\n");
+        WorkerStats stats[MAX_THREADS];
+        double time_ms = run_posix_workers(diff_files_worker_posix, dir_fd, indices, num_files, &create_payload, 0,
+                                           thread_count, stats);
+        int skipped = 0, failed = 0;
+        for (int i = 0; i < thread_count; i++) {
+            skipped += stats[i].skipped;
+            failed += stats[i].failures;
+        }
+        printf("\nFinished %d files on %d threads: %d written, %d unchanged, %d failed.\n", num_files, thread_count,
+               num_files - skipped - failed, skipped, failed);
+        printf("Total time taken: %.2f ms\n", time_ms);
+        print_worker_stats(stats, thread_count);
+        result = failed == 0 ? 0 : 1;
+    } else if (mode == GENERATOR_IO_URING || mode == GENERATOR_IO_URING_FIXED) {
+#if defined(DX_HAVE_IO_URING)
+        printf("Running on POSIX: Using io_uring linked openat/write/close chains.\n");
+        int written;
+        double time_ms = run_uring_generator(dir_fd, indices, num_files, &create_payload,
+                                             mode == GENERATOR_IO_URING_FIXED, &written);
+        if (time_ms < 0) {
+            fprintf(stderr, "io_uring is not usable here: %s\n", strerror((int)-time_ms));
+            result = 1;
+        } else {
+            printf("\nFinished creating %d of %d files.\n", written, num_files);
+            printf("Total time taken: %.2f ms\n", time_ms);
+            result = written == num_files ? 0 : 1;
+        }
+#else
+        fprintf(stderr, "io_uring is not available on this platform.\n");
+        result = 1;
+#endif
     } else {
-        worker_func = create_files_worker_posix;
-        content_to_write = padded_create_content;
-        action_description = "creating";
-    }
+        printf("Running on POSIX: Using high-performance mmap/openat methods.\n");
+        void *(*worker_func)(void *);
+        const Payload *payload;
+        const char *action_description;
+        char first_filename[64];
+        snprintf(first_filename, sizeof(first_filename), "%s%d%s", FILE_PREFIX, indices[0], FILE_SUFFIX);
+        if (faccessat(dir_fd, first_filename, F_OK, 0) == 0) {
+            worker_func = overwrite_files_mmap_worker_posix;
+            payload = &overwrite_payload;
+            action_description = "overwriting";
+        } else {
+            worker_func = create_files_worker_posix;
+            payload = &create_payload;
+            action_description = "creating";
+        }
 
-    pthread_t threads[NUM_THREADS];
-    ThreadArgs_POSIX args[NUM_THREADS];
-    int files_per_thread = num_files / NUM_THREADS;
-    for (int i = 0; i < NUM_THREADS; i++) {
-        args[i].indices = indices;
-        args[i].start = i * files_per_thread;
-        args[i].end = (i == NUM_THREADS - 1) ? num_files : (i + 1) * files_per_thread;
-        args[i].dir_fd = dir_fd;
-        args[i].content = content_to_write;
-        args[i].content_len = max_len;
-        pthread_create(&threads[i], NULL, worker_func, &args[i]);
-    }
+        WorkerStats stats[MAX_THREADS];
+        double time_ms = run_posix_workers(worker_func, dir_fd, indices, num_files, payload, MMAP_PWRITE_BELOW,
+                                           thread_count, stats);
 
-    for (int i = 0; i < NUM_THREADS; i++) {
-        pthread_join(threads[i], NULL);
+        printf("\nFinished %s %d files on %d threads.\n", action_description, num_files, thread_count);
+        printf("Total time taken: %.2f ms\n", time_ms);
+        print_worker_stats(stats, thread_count);
     }
     close(dir_fd);
 
-    clock_gettime(CLOCK_MONOTONIC, &end_time);
-    double time_ms = (end_time.tv_sec - start_time.tv_sec) * 1000.0 + (end_time.tv_nsec - start_time.tv_nsec) / 1000000.0;
-    printf("\nFinished %s %d files.\n", action_description, num_files);
-    printf("Total time taken: %.2f ms\n", time_ms);
-
 #elif defined(DX_PLATFORM_STANDARD)
+    if (sizes != SIZES_FIXED) {
+        fprintf(stderr, "Only fixed-size content is available on this platform.\n");
+        return 1;
+    }
     printf("Running on an unrecognized OS: Using generic standard C11 I/O fallback.\n");
     double start_time = get_monotonic_time();
-    thrd_t threads[NUM_THREADS];
-    ThreadData_Standard thread_data_array[NUM_THREADS];
-    int files_per_thread = num_files / NUM_THREADS;
-
-    for (int i = 0; i < NUM_THREADS; ++i) {
-        thread_data_array[i].indices = indices;
-        thread_data_array[i].start = i * files_per_thread;
-        thread_data_array[i].end = (i == NUM_THREADS - 1) ? num_files : (i + 1) * files_per_thread;
+    WorkQueue queue;
+    work_queue_init(&queue, indices, num_files);
+    thrd_t threads[MAX_THREADS];
+    ThreadData_Standard thread_data_array[MAX_THREADS];
+    WorkerStats stats[MAX_THREADS];
+
+    for (int i = 0; i < thread_count; ++i) {
+        memset(&thread_data_array[i], 0, sizeof(thread_data_array[i]));
+        thread_data_array[i].queue = &queue;
         thrd_create(&threads[i], create_files_worker_standard, &thread_data_array[i]);
     }
 
-    for (int i = 0; i < NUM_THREADS; ++i) {
+    for (int i = 0; i < thread_count; ++i) {
         thrd_join(threads[i], NULL);
+        stats[i] = thread_data_array[i].stats;
     }
 
     double end_time = get_monotonic_time();
     double time_ms = (end_time - start_time) * 1000.0;
-    printf("\nFinished creating %d files.\n", num_files);
+    printf("\nFinished creating %d files on %d threads.\n", num_files, thread_count);
     printf("Total time taken: %.2f ms\n", time_ms);
+    print_worker_stats(stats, thread_count);
 #endif
 
+#if defined(DX_PLATFORM_WINDOWS) || defined(DX_PLATFORM_POSIX)
+    payload_free(&create_payload);
+    payload_free(&overwrite_payload);
+    return result;
+#else
     return 0;
+#endif
 }
 
 int main(int argc, char *argv[]) {
     int num_files = 10000;
+    int thread_count = default_thread_count();
+    GeneratorMode mode = GENERATOR_AUTO;
+    SizeProfile sizes = SIZES_FIXED;
+    bool sizes_given = false;
 
-    if (argc > 1) {
-        num_files = atoi(argv[1]);
-        if (num_files <= 0) {
-            fprintf(stderr, "Invalid number of files: %s\n", argv[1]);
-            return 1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            thread_count = atoi(argv[++i]);
+            if (thread_count < 1 || thread_count > MAX_THREADS) {
+                fprintf(stderr, "Thread count must be between 1 and %d\n", MAX_THREADS);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--io-uring") == 0) {
+            mode = GENERATOR_IO_URING;
+        } else if (strcmp(argv[i], "--io-uring-fixed") == 0) {
+            mode = GENERATOR_IO_URING_FIXED;
+        } else if (strcmp(argv[i], "--diff") == 0) {
+            mode = GENERATOR_DIFF;
+        } else if (strcmp(argv[i], "--compare") == 0) {
+            mode = GENERATOR_COMPARE;
+        } else if (strcmp(argv[i], "--sizes") == 0 && i + 1 < argc) {
+            const char *profile = argv[++i];
+            if (strcmp(profile, "fixed") == 0) {
+                sizes = SIZES_FIXED;
+            } else if (strcmp(profile, "realistic") == 0) {
+                sizes = SIZES_REALISTIC;
+            } else {
+                fprintf(stderr, "Unknown size profile '%s'\n", profile);
+                return 1;
+            }
+            sizes_given = true;
+        } else {
+            num_files = atoi(argv[i]);
+            if (num_files <= 0) {
+                fprintf(stderr, "Invalid number of files: %s\n", argv[i]);
+                fprintf(stderr, "Usage: %s [num_files] [--threads N] [--sizes fixed|realistic] [--io-uring | --io-uring-fixed | --diff | --compare]\n", argv[0]);
+                return 1;
+            }
         }
     }
 
@@ -381,7 +1043,10 @@ int main(int argc, char *argv[]) {
         indices[i] = i + 1;
     }
 
-    int result = run_file_generator(indices, num_files);
+    // Comparisons are only meaningful on content shaped like a real tree.
+    if (mode == GENERATOR_COMPARE && !sizes_given) sizes = SIZES_REALISTIC;
+
+    int result = run_file_generator(indices, num_files, mode, sizes, thread_count);
 
     free(indices);
     return result;
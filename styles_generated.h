@@ -1440,6 +1440,7 @@ __flatbuffers_table_as_root(Styles)
 
 __flatbuffers_define_vector_field(0, Styles, static_rules, StaticRule_vec_t, 0)
 __flatbuffers_define_vector_field(1, Styles, dynamic_rules, DynamicRule_vec_t, 0)
+__flatbuffers_define_vector_field(2, Styles, name_index, flatbuffers_uint32_vec_t, 0)
 
 
 #include "flatcc/flatcc_epilogue.h"
@@ -1486,7 +1487,7 @@ __flatbuffers_build_table(flatbuffers_, DynamicRule, 3)
 static const flatbuffers_voffset_t __Styles_required[] = { 0 };
 typedef flatbuffers_ref_t Styles_ref_t;
 static Styles_ref_t Styles_clone(flatbuffers_builder_t *B, Styles_table_t t);
-__flatbuffers_build_table(flatbuffers_, Styles, 2)
+__flatbuffers_build_table(flatbuffers_, Styles, 3)
 
 #define __Property_formal_args , flatbuffers_string_ref_t v0, flatbuffers_string_ref_t v1
 #define __Property_call_args , v0, v1
@@ -1508,8 +1509,8 @@ __flatbuffers_build_table_prolog(flatbuffers_, DynamicProperty, DynamicProperty_
 static inline DynamicRule_ref_t DynamicRule_create(flatbuffers_builder_t *B __DynamicRule_formal_args);
 __flatbuffers_build_table_prolog(flatbuffers_, DynamicRule, DynamicRule_file_identifier, DynamicRule_type_identifier)
 
-#define __Styles_formal_args , StaticRule_vec_ref_t v0, DynamicRule_vec_ref_t v1
-#define __Styles_call_args , v0, v1
+#define __Styles_formal_args , StaticRule_vec_ref_t v0, DynamicRule_vec_ref_t v1, flatbuffers_uint32_vec_ref_t v2
+#define __Styles_call_args , v0, v1, v2
 static inline Styles_ref_t Styles_create(flatbuffers_builder_t *B __Styles_formal_args);
 __flatbuffers_build_table_prolog(flatbuffers_, Styles, Styles_file_identifier, Styles_type_identifier)
 
@@ -1619,12 +1620,14 @@ static DynamicRule_ref_t DynamicRule_clone(flatbuffers_builder_t *B, DynamicRule
 __flatbuffers_build_table_vector_field(0, flatbuffers_, Styles_static_rules, StaticRule, Styles)
 /* vector has keyed elements */
 __flatbuffers_build_table_vector_field(1, flatbuffers_, Styles_dynamic_rules, DynamicRule, Styles)
+__flatbuffers_build_vector_field(2, flatbuffers_, Styles_name_index, flatbuffers_uint32, uint32_t, Styles)
 
 static inline Styles_ref_t Styles_create(flatbuffers_builder_t *B __Styles_formal_args)
 {
     if (Styles_start(B)
         || Styles_static_rules_add(B, v0)
-        || Styles_dynamic_rules_add(B, v1)) {
+        || Styles_dynamic_rules_add(B, v1)
+        || Styles_name_index_add(B, v2)) {
         return 0;
     }
     return Styles_end(B);
@@ -1635,7 +1638,8 @@ static Styles_ref_t Styles_clone(flatbuffers_builder_t *B, Styles_table_t t)
     __flatbuffers_memoize_begin(B, t);
     if (Styles_start(B)
         || Styles_static_rules_pick(B, t)
-        || Styles_dynamic_rules_pick(B, t)) {
+        || Styles_dynamic_rules_pick(B, t)
+        || Styles_name_index_pick(B, t)) {
         return 0;
     }
     __flatbuffers_memoize_end(B, t, Styles_end(B));
@@ -1858,6 +1862,7 @@ static int Styles_verify_table(flatcc_table_verifier_descriptor_t *td)
     int ret;
     if ((ret = flatcc_verify_table_vector_field(td, 0, 0, &StaticRule_verify_table) /* static_rules */)) return ret;
     if ((ret = flatcc_verify_table_vector_field(td, 1, 0, &DynamicRule_verify_table) /* dynamic_rules */)) return ret;
+    if ((ret = flatcc_verify_vector_field(td, 2, 0, 4, 4, INT64_C(1073741823)) /* name_index */)) return ret;
     return flatcc_verify_ok;
 }
 
@@ -1,11 +1,18 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <pthread.h>
 
-#include <toml.h> 
+#include <toml.h>
 
 #include <flatcc/flatcc_builder.h>
 #include "styles_generated.h"
+#include "name_index.h"
 
 #define CHECK(x) do { \
     if (!(x)) { \
@@ -14,87 +21,1077 @@
     } \
 } while (0)
 
-int main(int argc, char *argv[]) {
-    const char *toml_path = (argc > 1) ? argv[1] : "styles.toml";
-    
+#define OUTPUT_PATH "styles.bin"
+#define WATCH_INTERVAL_MS 50
+#define MAX_JOBS 64
+
+// A static rule decoded out of the TOML document. Its properties are
+// serialized as key\0value\0... into one blob, which both feeds the builder
+// and keys the property-block cache. Name, blob and spans share one
+// allocation owned by the record.
+typedef struct {
+    size_t key, key_len;
+    size_t value, value_len;
+} PropSpan;
+
+typedef struct {
+    const char *name;
+    const char *blob;
+    size_t blob_len;
+    uint64_t hash;
+    const PropSpan *spans;
+    size_t span_count;
+} RuleRec;
+
+typedef struct {
+    RuleRec **items;
+    size_t count, cap;
+} RuleList;
+
+typedef struct {
+    char *data;
+    size_t len, cap;
+    PropSpan *spans;
+    size_t span_count, span_cap;
+} PropScratch;
+
+// Rules often share an identical property list (aliases, theme variants),
+// so each distinct list is emitted once and every rule using it points at
+// the same Property vector.
+typedef struct {
+    const RuleRec *rule;
+    Property_vec_ref_t ref;
+} PropBlock;
+
+typedef struct {
+    PropBlock *slots;
+    size_t slot_count;
+    size_t used;
+    size_t shared;
+} PropCache;
+
+static uint64_t hash_bytes(const char *data, size_t len) {
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)data[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static void scratch_append(PropScratch *sc, const char *s, size_t len) {
+    if (sc->len + len > sc->cap) {
+        while (sc->len + len > sc->cap) sc->cap = sc->cap ? sc->cap * 2 : 1024;
+        sc->data = realloc(sc->data, sc->cap);
+        CHECK(sc->data);
+    }
+    memcpy(sc->data + sc->len, s, len);
+    sc->len += len;
+}
+
+static void scratch_add_property(PropScratch *sc, const char *key, const char *value, size_t value_len) {
+    if (sc->span_count == sc->span_cap) {
+        sc->span_cap = sc->span_cap ? sc->span_cap * 2 : 16;
+        sc->spans = realloc(sc->spans, sc->span_cap * sizeof(PropSpan));
+        CHECK(sc->spans);
+    }
+    PropSpan *span = &sc->spans[sc->span_count++];
+    span->key = sc->len;
+    span->key_len = strlen(key);
+    scratch_append(sc, key, span->key_len + 1);
+    span->value = sc->len;
+    span->value_len = value_len;
+    scratch_append(sc, value, value_len);
+    scratch_append(sc, "", 1);
+}
+
+static void rule_list_push(RuleList *list, RuleRec *rule) {
+    if (list->count == list->cap) {
+        list->cap = list->cap ? list->cap * 2 : 64;
+        list->items = realloc(list->items, list->cap * sizeof(RuleRec*));
+        CHECK(list->items);
+    }
+    list->items[list->count++] = rule;
+}
+
+static void rule_list_free(RuleList *list) {
+    for (size_t i = 0; i < list->count; i++) free(list->items[i]);
+    list->count = 0;
+}
+
+static RuleRec *make_rule(const char *name, const PropScratch *sc) {
+    size_t name_len = strlen(name) + 1;
+    size_t spans_size = sc->span_count * sizeof(PropSpan);
+    RuleRec *rule = malloc(sizeof(RuleRec) + spans_size + sc->len + name_len);
+    CHECK(rule);
+
+    char *mem = (char*)(rule + 1);
+    memcpy(mem, sc->spans, spans_size);
+    rule->spans = (const PropSpan*)mem;
+    rule->span_count = sc->span_count;
+    memcpy(mem + spans_size, sc->data, sc->len);
+    rule->blob = mem + spans_size;
+    rule->blob_len = sc->len;
+    rule->hash = hash_bytes(rule->blob, rule->blob_len);
+    memcpy(mem + spans_size + sc->len, name, name_len);
+    rule->name = mem + spans_size + sc->len;
+    return rule;
+}
+
+// Decodes every static rule of a parsed document into `out`, in document
+// order. Errors are reported against `toml_path` and return -1.
+static int compile_rules(toml_table_t *conf, const char *toml_path, PropScratch *sc, RuleList *out) {
+    toml_table_t *static_rules = toml_table_in(conf, "static_rules");
+    if (!static_rules) return 0;
+
+    // Walk entries by position: looking each key back up with
+    // toml_table_in is a linear scan and made generation O(n^2).
+    if (toml_table_nkval(static_rules) > 0 || toml_table_narr(static_rules) > 0) {
+        fprintf(stderr, "Error: Could not find table for static_rule '%s' in '%s'.\n", toml_key_in(static_rules, 0), toml_path);
+        return -1;
+    }
+
+    int rule_count = toml_table_ntab(static_rules);
+    for (int i = 0; i < rule_count; i++) {
+        toml_table_t *rule = toml_table_tab_at(static_rules, i);
+        const char *key = toml_table_key(rule);
+
+        if (toml_table_narr(rule) > 0 || toml_table_ntab(rule) > 0) {
+            fprintf(stderr, "Error: Value for property '%s' in static_rule '%s' is not a string.\n",
+                    toml_key_in(rule, toml_table_nkval(rule)), key);
+            return -1;
+        }
+
+        sc->len = 0;
+        sc->span_count = 0;
+        int prop_count = toml_table_nkval(rule);
+        for (int j = 0; j < prop_count; j++) {
+            const char *prop_key;
+            const char *value;
+            int value_len;
+
+            // Plain strings are borrowed straight from the document;
+            // only values with escapes need a decoded copy.
+            if (toml_string_kval_view(rule, j, &prop_key, &value, &value_len) == 0) {
+                scratch_add_property(sc, prop_key, value, (size_t)value_len);
+            } else {
+                toml_datum_t prop_val = toml_string_kval_at(rule, j, &prop_key);
+                if (!prop_val.ok) {
+                    fprintf(stderr, "Error: Value for property '%s' in static_rule '%s' is not a string.\n", prop_key, key);
+                    return -1;
+                }
+                scratch_add_property(sc, prop_key, prop_val.u.s, strlen(prop_val.u.s));
+                free(prop_val.u.s);
+            }
+        }
+        rule_list_push(out, make_rule(key, sc));
+    }
+    return 0;
+}
+
+static PropBlock *prop_cache_find(PropCache *cache, const RuleRec *rule) {
+    size_t mask = cache->slot_count - 1;
+    for (size_t i = rule->hash & mask; ; i = (i + 1) & mask) {
+        PropBlock *b = &cache->slots[i];
+        if (!b->rule) return b;
+        if (b->rule->hash == rule->hash && b->rule->blob_len == rule->blob_len &&
+            memcmp(b->rule->blob, rule->blob, rule->blob_len) == 0) return b;
+    }
+}
+
+static void prop_cache_reset(PropCache *cache, size_t rule_count) {
+    size_t slot_count = 1024;
+    while (slot_count < 2 * rule_count) slot_count *= 2;
+    if (slot_count != cache->slot_count) {
+        free(cache->slots);
+        cache->slots = malloc(slot_count * sizeof(PropBlock));
+        CHECK(cache->slots);
+        cache->slot_count = slot_count;
+    }
+    memset(cache->slots, 0, slot_count * sizeof(PropBlock));
+    cache->used = 0;
+    cache->shared = 0;
+}
+
+static Property_vec_ref_t emit_properties(flatcc_builder_t *builder, PropCache *cache, const RuleRec *rule) {
+    PropBlock *block = prop_cache_find(cache, rule);
+    if (block->rule) {
+        cache->shared++;
+        return block->ref;
+    }
+
+    Property_vec_start(builder);
+    for (size_t j = 0; j < rule->span_count; j++) {
+        const PropSpan *span = &rule->spans[j];
+        Property_ref_t prop_ref = Property_create(builder,
+            flatcc_builder_create_string(builder, rule->blob + span->key, span->key_len),
+            flatcc_builder_create_string(builder, rule->blob + span->value, span->value_len));
+        Property_vec_push(builder, prop_ref);
+    }
+    block->rule = rule;
+    block->ref = Property_vec_end(builder);
+    cache->used++;
+    return block->ref;
+}
+
+// Returns the name_index words for `rules` (see name_index.h), or NULL if
+// no displacement could be found for some bucket, in which case readers
+// fall back to scanning the rules.
+static uint32_t *build_name_index(RuleRec **rules, size_t rule_count, size_t *len_out) {
+    if (rule_count == 0 || rule_count > UINT32_MAX / 2) return NULL;
+    uint32_t n = (uint32_t)rule_count;
+    uint32_t bucket_count = n / NAME_INDEX_BUCKET_LOAD + 1;
+    size_t len = 1 + (size_t)bucket_count + n;
+    uint32_t *index = calloc(len, sizeof(uint32_t));
+    NameHash *keys = malloc(n * sizeof(NameHash));
+    uint32_t *members = malloc(n * sizeof(uint32_t));
+    uint32_t *start = calloc((size_t)bucket_count + 1, sizeof(uint32_t));
+    CHECK(index && keys && members && start);
+
+    // Group the rules by bucket.
+    for (uint32_t i = 0; i < n; i++) {
+        keys[i] = name_index_hash(rules[i]->name, bucket_count, n);
+        start[keys[i].bucket + 1]++;
+    }
+    uint32_t max_size = 0;
+    for (uint32_t b = 0; b < bucket_count; b++) {
+        if (start[b + 1] > max_size) max_size = start[b + 1];
+        start[b + 1] += start[b];
+    }
+    uint32_t *fill = malloc((size_t)bucket_count * sizeof(uint32_t));
+    CHECK(fill);
+    memcpy(fill, start, (size_t)bucket_count * sizeof(uint32_t));
+    for (uint32_t i = 0; i < n; i++) members[fill[keys[i].bucket]++] = i;
+
+    // Place the largest buckets first, while the table is still sparse.
+    uint32_t *by_size = malloc((size_t)bucket_count * sizeof(uint32_t));
+    uint32_t *size_start = calloc((size_t)max_size + 2, sizeof(uint32_t));
+    uint32_t *slots = malloc(((size_t)max_size + 1) * sizeof(uint32_t));
+    CHECK(by_size && size_start && slots);
+    for (uint32_t b = 0; b < bucket_count; b++) size_start[max_size - (start[b + 1] - start[b]) + 1]++;
+    for (uint32_t i = 0; i <= max_size; i++) size_start[i + 1] += size_start[i];
+    for (uint32_t b = 0; b < bucket_count; b++) by_size[size_start[max_size - (start[b + 1] - start[b])]++] = b;
+
+    index[0] = bucket_count;
+    uint32_t *displacement = index + 1;
+    uint32_t *slot_rule = index + 1 + bucket_count;
+    for (uint32_t i = 0; i < n; i++) slot_rule[i] = UINT32_MAX;
+
+    bool ok = true;
+    uint32_t next_free = 0;
+    for (uint32_t o = 0; ok && o < bucket_count; o++) {
+        uint32_t b = by_size[o];
+        const uint32_t *m = members + start[b];
+        uint32_t k = start[b + 1] - start[b];
+        if (k == 0) break;
+        if (k == 1) {
+            // A single name can take any free slot directly.
+            while (slot_rule[next_free] != UINT32_MAX) next_free++;
+            displacement[b] = (next_free + n - keys[m[0]].f1) % n;
+            slot_rule[next_free] = m[0];
+            continue;
+        }
+        ok = false;
+        for (uint64_t d0 = 0; !ok && d0 <= (UINT32_MAX - n) / n; d0++) {
+            bool distinct = true;
+            for (uint32_t i = 0; distinct && i < k; i++) {
+                slots[i] = (uint32_t)((keys[m[i]].f1 + d0 * keys[m[i]].f2) % n);
+                for (uint32_t j = 0; j < i; j++) {
+                    if (slots[j] == slots[i]) distinct = false;
+                }
+            }
+            if (!distinct) continue;
+            for (uint32_t d1 = 0; !ok && d1 < n; d1++) {
+                uint32_t i = 0;
+                while (i < k && slot_rule[(slots[i] + d1) % n] == UINT32_MAX) i++;
+                if (i < k) continue;
+                for (i = 0; i < k; i++) slot_rule[(slots[i] + d1) % n] = m[i];
+                displacement[b] = (uint32_t)(d0 * n + d1);
+                ok = true;
+            }
+        }
+    }
+
+    free(keys);
+    free(members);
+    free(start);
+    free(fill);
+    free(by_size);
+    free(size_start);
+    free(slots);
+    if (!ok) {
+        free(index);
+        return NULL;
+    }
+    *len_out = len;
+    return index;
+}
+
+// Emits a complete Styles buffer for `rules` into the (reset) builder. The
+// name index is only built for whole documents, not for segments.
+static void emit_styles(flatcc_builder_t *builder, PropCache *cache, RuleRec **rules, size_t rule_count, bool with_index) {
+    flatcc_builder_reset(builder);
+    prop_cache_reset(cache, rule_count);
+
+    StaticRule_vec_start(builder);
+    for (size_t i = 0; i < rule_count; i++) {
+        Property_vec_ref_t props_vec = emit_properties(builder, cache, rules[i]);
+        StaticRule_ref_t rule_ref = StaticRule_create(builder,
+            flatcc_builder_create_string_str(builder, rules[i]->name),
+            props_vec);
+        StaticRule_vec_push(builder, rule_ref);
+    }
+    StaticRule_vec_ref_t static_rules_vec = StaticRule_vec_end(builder);
+
+    DynamicRule_vec_start(builder);
+    DynamicRule_vec_ref_t dynamic_rules_vec = DynamicRule_vec_end(builder);
+
+    size_t index_len;
+    uint32_t *index = with_index ? build_name_index(rules, rule_count, &index_len) : NULL;
+    flatbuffers_uint32_vec_ref_t name_index_vec = index ? flatbuffers_uint32_vec_create(builder, index, index_len) : 0;
+    free(index);
+
+    Styles_start_as_root(builder);
+    Styles_static_rules_add(builder, static_rules_vec);
+    Styles_dynamic_rules_add(builder, dynamic_rules_vec);
+    if (name_index_vec) Styles_name_index_add(builder, name_index_vec);
+    Styles_end_as_root(builder);
+}
+
+// Writes to a sibling file renamed into place, so a running watcher never
+// maps a torn styles.bin.
+static int write_output(const void *buf, size_t size) {
+    FILE *out = fopen(OUTPUT_PATH ".tmp", "wb");
+    if (!out) {
+        fprintf(stderr, "Error: Failed to open output file '" OUTPUT_PATH "' for writing.\n");
+        return -1;
+    }
+    bool ok = fwrite(buf, 1, size, out) == size;
+    ok = fclose(out) == 0 && ok;
+    if (!ok || rename(OUTPUT_PATH ".tmp", OUTPUT_PATH) != 0) {
+        fprintf(stderr, "Error: Failed to write output file '" OUTPUT_PATH "'.\n");
+        remove(OUTPUT_PATH ".tmp");
+        return -1;
+    }
+    return 0;
+}
+
+static int write_styles(flatcc_builder_t *builder, PropCache *cache, RuleRec **rules, size_t rule_count, size_t *size_out) {
+    emit_styles(builder, cache, rules, rule_count, true);
+
+    size_t size;
+    // The direct buffer is only available while the output fits in the
+    // emitter's first page; larger configs need a finalized copy.
+    void *buf = flatcc_builder_get_direct_buffer(builder, &size);
+    void *copy = NULL;
+    if (!buf) {
+        buf = copy = flatcc_builder_finalize_buffer(builder, &size);
+        CHECK(buf);
+    }
+    int rc = write_output(buf, size);
+    flatcc_builder_free(copy);
+    *size_out = size;
+    return rc;
+}
+
+// A segment is a standalone Styles buffer holding a run of consecutive
+// rules. write_segments() lays several of them out behind a small root whose
+// rule vector points into each, which lets segments be built independently
+// (per thread, or once and reused across --watch edits). Strings and
+// property blocks are only shared within a segment.
+typedef struct {
+    uint8_t *data;
+    size_t size;
+    uint32_t *rule_pos;
+    size_t rule_count;
+    // Only used by the --watch segment cache.
+    uint64_t key;
+    uint64_t *members;
+    size_t member_count;
+    unsigned generation;
+} Segment;
+
+static void fill_segment(Segment *g, flatcc_builder_t *builder, PropCache *props, RuleRec **rules, size_t rule_count) {
+    emit_styles(builder, props, rules, rule_count, false);
+    g->data = flatcc_builder_finalize_buffer(builder, &g->size);
+    CHECK(g->data);
+    g->rule_count = rule_count;
+    g->rule_pos = malloc((rule_count + 1) * sizeof(uint32_t));
+    CHECK(g->rule_pos);
+    StaticRule_vec_t vec = Styles_static_rules(Styles_as_root(g->data));
+    for (size_t i = 0; i < rule_count; i++) {
+        g->rule_pos[i] = (uint32_t)((const uint8_t *)StaticRule_vec_at(vec, i) - g->data);
+    }
+}
+
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    put_u16(p, (uint16_t)v);
+    put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+// Lays out the root followed by the segments:
+//   0  uoffset to the Styles table
+//   4  vtable {10, 16, static_rules @4, dynamic_rules @8, name_index @12}
+//   16 Styles table: soffset to the vtable, then the three vector uoffsets
+//   32 dynamic_rules, empty
+//   36 name_index, empty if it could not be built
+//   .. static_rules, one uoffset per rule into the segments
+static int write_segments(Segment **segments, size_t segment_count, size_t rule_count,
+                          const uint32_t *index, size_t index_len, size_t *size_out) {
+    size_t vec = 40 + 4 * index_len;
+    size_t head = (vec + 4 + 4 * rule_count + 7) & ~(size_t)7;
+    size_t size = head;
+    for (size_t i = 0; i < segment_count; i++) size = ((size + segments[i]->size) + 7) & ~(size_t)7;
+    uint8_t *buf = calloc(1, size);
+    CHECK(buf);
+
+    put_u32(buf, 16);
+    put_u16(buf + 4, 10);
+    put_u16(buf + 6, 16);
+    put_u16(buf + 8, 4);
+    put_u16(buf + 10, 8);
+    put_u16(buf + 12, 12);
+    put_u32(buf + 16, 12);
+    put_u32(buf + 20, (uint32_t)(vec - 20));
+    put_u32(buf + 24, 8);
+    put_u32(buf + 28, 8);
+    put_u32(buf + 36, (uint32_t)index_len);
+    for (size_t i = 0; i < index_len; i++) put_u32(buf + 40 + 4 * i, index[i]);
+    put_u32(buf + vec, (uint32_t)rule_count);
+
+    size_t elem = vec + 4;
+    size_t pos = head;
+    for (size_t i = 0; i < segment_count; i++) {
+        const Segment *g = segments[i];
+        memcpy(buf + pos, g->data, g->size);
+        for (size_t r = 0; r < g->rule_count; r++, elem += 4) {
+            put_u32(buf + elem, (uint32_t)(pos + g->rule_pos[r] - elem));
+        }
+        pos = (pos + g->size + 7) & ~(size_t)7;
+    }
+
+    int rc = write_output(buf, size);
+    free(buf);
+    *size_out = size;
+    return rc;
+}
+
+// Rule shards for one-shot runs. Each worker owns a builder and property
+// cache and builds its slice of the rules into one segment; the segments are
+// written in rule order, so the output does not depend on scheduling.
+#define SHARD_MIN_RULES 4096
+
+typedef struct {
+    RuleRec **rules;
+    size_t rule_count;
+    Segment segment;
+    size_t shared_strings, unique_strings, shared_blocks;
+} Shard;
+
+static void *build_shard(void *arg) {
+    Shard *shard = arg;
+    flatcc_builder_t builder;
+    flatcc_builder_init(&builder);
+    CHECK(flatcc_builder_set_string_interning(&builder, 1) == 0);
+    PropCache props = {0};
+    fill_segment(&shard->segment, &builder, &props, shard->rules, shard->rule_count);
+    flatcc_builder_get_string_interning_stats(&builder, &shard->shared_strings, &shard->unique_strings);
+    shard->shared_blocks = props.shared;
+    free(props.slots);
+    flatcc_builder_clear(&builder);
+    return NULL;
+}
+
+static int write_sharded(RuleRec **rules, size_t rule_count, int jobs, const char *toml_path) {
+    Shard *shards = calloc((size_t)jobs, sizeof(Shard));
+    pthread_t *threads = malloc((size_t)jobs * sizeof(pthread_t));
+    Segment **segments = malloc((size_t)jobs * sizeof(Segment*));
+    CHECK(shards && threads && segments);
+
+    size_t start = 0;
+    for (int i = 0; i < jobs; i++) {
+        size_t end = rule_count * (size_t)(i + 1) / (size_t)jobs;
+        shards[i].rules = rules + start;
+        shards[i].rule_count = end - start;
+        segments[i] = &shards[i].segment;
+        start = end;
+    }
+    // The calling thread builds the first shard itself.
+    for (int i = 1; i < jobs; i++) CHECK(pthread_create(&threads[i], NULL, build_shard, &shards[i]) == 0);
+    build_shard(&shards[0]);
+    for (int i = 1; i < jobs; i++) pthread_join(threads[i], NULL);
+
+    size_t size, index_len = 0;
+    uint32_t *index = build_name_index(rules, rule_count, &index_len);
+    int rc = write_segments(segments, (size_t)jobs, rule_count, index, index_len, &size);
+    free(index);
+    size_t shared = 0, unique = 0, blocks = 0;
+    for (int i = 0; i < jobs; i++) {
+        shared += shards[i].shared_strings;
+        unique += shards[i].unique_strings;
+        blocks += shards[i].shared_blocks;
+        flatcc_builder_free(shards[i].segment.data);
+        free(shards[i].segment.rule_pos);
+    }
+    if (rc == 0) {
+        printf("Successfully converted '%s' to '" OUTPUT_PATH "' (%zu bytes, %d shards, %zu unique strings, %zu shared, %zu shared property blocks)\n",
+               toml_path, size, jobs, unique, shared, blocks);
+    }
+    free(shards);
+    free(threads);
+    free(segments);
+    return rc;
+}
+
+static void print_summary(const char *toml_path, flatcc_builder_t *builder, const PropCache *cache, size_t size) {
+    size_t shared, unique;
+    flatcc_builder_get_string_interning_stats(builder, &shared, &unique);
+    printf("Successfully converted '%s' to '" OUTPUT_PATH "' (%zu bytes, %zu unique strings, %zu shared, %zu shared property blocks)\n",
+           toml_path, size, unique, shared, cache->shared);
+}
+
+static int generate_once(const char *toml_path, int jobs, flatcc_builder_t *builder, PropCache *cache) {
     FILE *fp = fopen(toml_path, "r");
     if (!fp) {
         fprintf(stderr, "Error: Cannot open input file '%s'.\n", toml_path);
-        fprintf(stderr, "Usage: %s [path_to_styles.toml]\n", argv[0]);
+        fprintf(stderr, "Usage: styles_generator [--watch] [--jobs N] [path_to_styles.toml]\n");
         return 1;
     }
-    
+
     char errbuf[200];
-    toml_table_t *conf = toml_parse_file(fp, errbuf, sizeof(errbuf));
+    toml_table_t *conf = toml_parse_file_arena(fp, errbuf, sizeof(errbuf));
     fclose(fp);
-    
+
     if (!conf) {
         fprintf(stderr, "Error parsing TOML file '%s': %s\n", toml_path, errbuf);
         return 1;
     }
 
-    flatcc_builder_t builder;
-    flatcc_builder_init(&builder);
+    PropScratch scratch = {0};
+    RuleList rules = {0};
+    size_t size = 0;
+    int rc = compile_rules(conf, toml_path, &scratch, &rules) == 0 ? 0 : 1;
+    if (rc == 0) {
+        // Small configs are not worth splitting, and a single shard keeps
+        // strings and property blocks shared across the whole document.
+        if (jobs > (int)(rules.count / SHARD_MIN_RULES)) jobs = (int)(rules.count / SHARD_MIN_RULES);
+        if (jobs > 1) {
+            rc = write_sharded(rules.items, rules.count, jobs, toml_path) == 0 ? 0 : 1;
+        } else {
+            rc = write_styles(builder, cache, rules.items, rules.count, &size) == 0 ? 0 : 1;
+            if (rc == 0) print_summary(toml_path, builder, cache, size);
+        }
+    }
 
-    StaticRule_vec_start(&builder);
-    toml_table_t *static_rules = toml_table_in(conf, "static_rules");
-    if (static_rules) {
-        for (int i = 0; ; i++) {
-            const char *key = toml_key_in(static_rules, i);
-            if (!key) break;
-
-            toml_table_t *rule = toml_table_in(static_rules, key);
-            if (!rule) {
-                fprintf(stderr, "Error: Could not find table for static_rule '%s' in '%s'.\n", key, toml_path);
-                exit(1);
-            }
+    toml_free(conf);
+    rule_list_free(&rules);
+    free(rules.items);
+    free(scratch.data);
+    free(scratch.spans);
+    return rc;
+}
 
-            Property_vec_start(&builder);
-            for (int j = 0; ; j++) {
-                const char *prop_key = toml_key_in(rule, j);
-                if (!prop_key) break;
+// --watch keeps every rule decoded between edits. The file is split into
+// sections at lines starting with '[' and each section's decoded rules are
+// cached under the hash of its text, so an edit re-parses only the sections
+// it touched before the buffer is rebuilt. Anything the section split
+// cannot represent, such as a parse error inside a section or a rule
+// defined twice, falls back to a full parse, which also reports the error.
+typedef struct {
+    uint64_t hash;
+    char *text;
+    size_t len;
+    RuleList rules;
+    unsigned generation;
+} Section;
 
-                toml_datum_t prop_val = toml_string_in(rule, prop_key);
-                if (!prop_val.ok) {
-                    fprintf(stderr, "Error: Value for property '%s' in static_rule '%s' is not a string.\n", prop_key, key);
-                    exit(1);
-                }
+typedef struct {
+    Section **items;
+    size_t count, cap;
+} SectionList;
 
-                Property_ref_t prop_ref = Property_create(&builder, 
-                    flatcc_builder_create_string_str(&builder, prop_key),
-                    flatcc_builder_create_string_str(&builder, prop_val.u.s));
-                Property_vec_push(&builder, prop_ref);
-                free(prop_val.u.s);
+typedef struct {
+    uint64_t hash;
+    const RuleRec *rule;
+    const Section *section;
+} NameEntry;
+
+typedef struct {
+    Section **slots;
+    size_t slot_count;
+    size_t used;
+    // Every cached rule name, possibly several times; an entry only counts
+    // while its section is part of the current generation.
+    NameEntry *names;
+    size_t name_slot_count;
+    size_t name_used;
+    unsigned generation;
+} SectionCache;
+
+static Section **section_slot(SectionCache *cache, uint64_t hash, const char *text, size_t len) {
+    size_t mask = cache->slot_count - 1;
+    for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+        Section *s = cache->slots[i];
+        if (!s || (s->hash == hash && s->len == len && memcmp(s->text, text, len) == 0)) return &cache->slots[i];
+    }
+}
+
+static void section_free(Section *s) {
+    rule_list_free(&s->rules);
+    free(s->rules.items);
+    free(s->text);
+    free(s);
+}
+
+static void names_insert(SectionCache *cache, const Section *s) {
+    size_t mask = cache->name_slot_count - 1;
+    for (size_t r = 0; r < s->rules.count; r++) {
+        const RuleRec *rule = s->rules.items[r];
+        uint64_t hash = hash_bytes(rule->name, strlen(rule->name));
+        size_t i = hash & mask;
+        while (cache->names[i].rule) i = (i + 1) & mask;
+        cache->names[i] = (NameEntry){ hash, rule, s };
+        cache->name_used++;
+    }
+}
+
+// Returns true if a rule of `s` is also defined by another live section.
+static bool names_conflict(const SectionCache *cache, const Section *s) {
+    size_t mask = cache->name_slot_count - 1;
+    for (size_t r = 0; r < s->rules.count; r++) {
+        const char *name = s->rules.items[r]->name;
+        uint64_t hash = hash_bytes(name, strlen(name));
+        for (size_t i = hash & mask; cache->names[i].rule; i = (i + 1) & mask) {
+            const NameEntry *e = &cache->names[i];
+            if (e->hash == hash && e->section != s && e->section->generation == cache->generation &&
+                strcmp(e->rule->name, name) == 0) return true;
+        }
+    }
+    return false;
+}
+
+// Rebuilds both tables, dropping sections not used by the current
+// generation when `drop_stale` is set, and sized for `extra` more entries.
+static void section_cache_rebuild(SectionCache *cache, bool drop_stale, size_t extra) {
+    Section **old = cache->slots;
+    size_t old_count = cache->slot_count;
+    size_t keep = 0, rule_count = 0;
+    for (size_t i = 0; i < old_count; i++) {
+        if (old[i] && (!drop_stale || old[i]->generation == cache->generation)) {
+            keep++;
+            rule_count += old[i]->rules.count;
+        }
+    }
+
+    cache->slot_count = 1024;
+    while (cache->slot_count < 2 * (keep + extra)) cache->slot_count *= 2;
+    cache->slots = calloc(cache->slot_count, sizeof(Section*));
+    CHECK(cache->slots);
+    cache->used = 0;
+
+    free(cache->names);
+    cache->name_slot_count = 1024;
+    while (cache->name_slot_count < 2 * (rule_count + extra)) cache->name_slot_count *= 2;
+    cache->names = calloc(cache->name_slot_count, sizeof(NameEntry));
+    CHECK(cache->names);
+    cache->name_used = 0;
+
+    for (size_t i = 0; i < old_count; i++) {
+        Section *s = old[i];
+        if (!s) continue;
+        if (drop_stale && s->generation != cache->generation) {
+            section_free(s);
+            continue;
+        }
+        *section_slot(cache, s->hash, s->text, s->len) = s;
+        cache->used++;
+        names_insert(cache, s);
+    }
+    free(old);
+}
+
+static char *read_file(const char *path, size_t *len) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return NULL;
+    struct stat st;
+    if (fstat(fileno(fp), &st) != 0) {
+        fclose(fp);
+        return NULL;
+    }
+    char *buf = malloc((size_t)st.st_size + 1);
+    CHECK(buf);
+    *len = fread(buf, 1, (size_t)st.st_size, fp);
+    buf[*len] = '\0';
+    fclose(fp);
+    return buf;
+}
+
+static void section_list_push(SectionList *list, Section *s) {
+    if (list->count == list->cap) {
+        list->cap = list->cap ? list->cap * 2 : 256;
+        list->items = realloc(list->items, list->cap * sizeof(Section*));
+        CHECK(list->items);
+    }
+    list->items[list->count++] = s;
+}
+
+static bool is_section_start(const char *p) {
+    while (*p == ' ' || *p == '\t') p++;
+    return *p == '[';
+}
+
+static Section *parse_section(SectionCache *cache, char *text, size_t len, uint64_t hash,
+                              const char *toml_path, PropScratch *sc) {
+    char errbuf[200];
+    char saved = text[len];
+    text[len] = '\0';
+    toml_table_t *conf = toml_parse_n(text, len, errbuf, sizeof(errbuf));
+    text[len] = saved;
+    if (!conf) return NULL;
+
+    Section *s = calloc(1, sizeof(Section));
+    CHECK(s);
+    int rc = compile_rules(conf, toml_path, sc, &s->rules);
+    toml_free(conf);
+    if (rc != 0) {
+        section_free(s);
+        return NULL;
+    }
+    s->hash = hash;
+    s->len = len;
+    s->text = malloc(len);
+    CHECK(s->text);
+    memcpy(s->text, text, len);
+
+    if (2 * (cache->used + 1) > cache->slot_count || 2 * (cache->name_used + s->rules.count) > cache->name_slot_count) {
+        section_cache_rebuild(cache, false, s->rules.count + 1);
+    }
+    *section_slot(cache, hash, text, len) = s;
+    cache->used++;
+    names_insert(cache, s);
+    return s;
+}
+
+// Collects the sections of `buf` in document order, reusing cached ones.
+// Returns the number of sections that had to be parsed, or -1 if the
+// document has to go through a full parse instead.
+static long collect_sections(SectionCache *cache, char *buf, size_t len, const char *toml_path,
+                             PropScratch *sc, SectionList *order) {
+    unsigned previous = cache->generation++;
+    long parsed = 0;
+    size_t live = 0;
+    Section **entering = NULL;
+    size_t entering_count = 0, entering_cap = 0;
+    long result = 0;
+
+    size_t start = 0;
+    while (start < len) {
+        size_t end = start;
+        do {
+            const char *nl = memchr(buf + end, '\n', len - end);
+            end = nl ? (size_t)(nl - buf) + 1 : len;
+        } while (end < len && !is_section_start(buf + end));
+
+        uint64_t hash = hash_bytes(buf + start, end - start);
+        Section *s = *section_slot(cache, hash, buf + start, end - start);
+        if (!s) {
+            s = parse_section(cache, buf + start, end - start, hash, toml_path, sc);
+            if (!s) {
+                result = -1;
+                break;
+            }
+            parsed++;
+        }
+
+        if (s->generation == cache->generation) {
+            // The same text twice defines its rules twice.
+            if (s->rules.count > 0) {
+                result = -1;
+                break;
             }
-            Property_vec_ref_t props_vec = Property_vec_end(&builder);
+        } else {
+            // Sections that were not live last time may clash with others.
+            if (s->generation != previous) {
+                if (entering_count == entering_cap) {
+                    entering_cap = entering_cap ? entering_cap * 2 : 16;
+                    entering = realloc(entering, entering_cap * sizeof(Section*));
+                    CHECK(entering);
+                }
+                entering[entering_count++] = s;
+            }
+            s->generation = cache->generation;
+            live++;
+        }
+        section_list_push(order, s);
+        start = end;
+    }
+
+    for (size_t i = 0; result == 0 && i < entering_count; i++) {
+        if (names_conflict(cache, entering[i])) result = -1;
+    }
+    free(entering);
+    // After a failure no section counts as live before the next pass, so
+    // that pass checks every one of them for clashes again.
+    if (result != 0) cache->generation++;
+
+    // Stale sections are kept (an undo hits the cache) until they outnumber
+    // the live ones.
+    if (result == 0 && cache->used - live > live + 64) section_cache_rebuild(cache, true, 0);
+    return result == 0 ? parsed : -1;
+}
 
-            StaticRule_ref_t rule_ref = StaticRule_create(&builder, 
-                flatcc_builder_create_string_str(&builder, key), 
-                props_vec);
-            StaticRule_vec_push(&builder, rule_ref);
+// In watch mode consecutive sections are grouped into segments at
+// content-defined boundaries, so an edit changes the membership of only the
+// group around it and every other segment is reused as is.
+#define SEGMENT_BOUNDARY_MASK 63
+#define SEGMENT_MAX_RULES 256
+
+typedef struct {
+    Segment **slots;
+    size_t slot_count;
+    size_t used;
+    unsigned generation;
+    // The name index only depends on the rule names, which most edits
+    // leave alone.
+    uint64_t index_names;
+    uint32_t *index;
+    size_t index_len;
+} SegmentCache;
+
+static Segment **segment_slot(SegmentCache *cache, uint64_t key, const uint64_t *members, size_t member_count) {
+    size_t mask = cache->slot_count - 1;
+    for (size_t i = key & mask; ; i = (i + 1) & mask) {
+        Segment *g = cache->slots[i];
+        if (!g || (g->key == key && g->member_count == member_count &&
+                   memcmp(g->members, members, member_count * sizeof(uint64_t)) == 0)) return &cache->slots[i];
+    }
+}
+
+static void segment_free(Segment *g) {
+    free(g->members);
+    flatcc_builder_free(g->data);
+    free(g->rule_pos);
+    free(g);
+}
+
+static void segment_cache_rebuild(SegmentCache *cache, bool drop_stale, size_t extra) {
+    Segment **old = cache->slots;
+    size_t old_count = cache->slot_count;
+    size_t keep = 0;
+    for (size_t i = 0; i < old_count; i++) {
+        if (old[i] && (!drop_stale || old[i]->generation == cache->generation)) keep++;
+    }
+
+    cache->slot_count = 256;
+    while (cache->slot_count < 2 * (keep + extra)) cache->slot_count *= 2;
+    cache->slots = calloc(cache->slot_count, sizeof(Segment*));
+    CHECK(cache->slots);
+    cache->used = 0;
+
+    for (size_t i = 0; i < old_count; i++) {
+        Segment *g = old[i];
+        if (!g) continue;
+        if (drop_stale && g->generation != cache->generation) {
+            segment_free(g);
+            continue;
         }
+        *segment_slot(cache, g->key, g->members, g->member_count) = g;
+        cache->used++;
     }
-    StaticRule_vec_ref_t static_rules_vec = StaticRule_vec_end(&builder);
+    free(old);
+}
+
+static Segment *build_segment(SegmentCache *cache, flatcc_builder_t *builder, PropCache *props, const RuleList *rules,
+                              uint64_t key, const uint64_t *members, size_t member_count) {
+    Segment *g = calloc(1, sizeof(Segment));
+    CHECK(g);
+    fill_segment(g, builder, props, rules->items, rules->count);
+    g->key = key;
+    g->member_count = member_count;
+    g->members = malloc(member_count * sizeof(uint64_t));
+    CHECK(g->members);
+    memcpy(g->members, members, member_count * sizeof(uint64_t));
+
+    if (2 * (cache->used + 1) > cache->slot_count) segment_cache_rebuild(cache, false, 1);
+    *segment_slot(cache, key, members, member_count) = g;
+    cache->used++;
+    return g;
+}
+
+// Groups `order` into segments, building those not cached, and writes
+// styles.bin out of them. Returns the number of segments built.
+static long write_segmented(SegmentCache *cache, const SectionList *order, flatcc_builder_t *builder,
+                            PropCache *props, size_t *rule_count, size_t *size_out) {
+    cache->generation++;
+    Segment **segments = NULL;
+    size_t segment_count = 0, segment_cap = 0;
+    uint64_t *members = malloc((order->count + 1) * sizeof(uint64_t));
+    CHECK(members);
+    size_t member_count = 0;
+    RuleList group = {0}, all = {0};
+    long built = 0;
+    size_t live = 0;
+    *rule_count = 0;
+
+    for (size_t i = 0; i < order->count; i++) {
+        const Section *s = order->items[i];
+        members[member_count++] = s->hash;
+        for (size_t r = 0; r < s->rules.count; r++) {
+            rule_list_push(&group, s->rules.items[r]);
+            rule_list_push(&all, s->rules.items[r]);
+        }
+        if (i + 1 < order->count && ((s->hash >> 32) & SEGMENT_BOUNDARY_MASK) != 0 &&
+            group.count < SEGMENT_MAX_RULES) continue;
 
-    DynamicRule_vec_start(&builder);
-    DynamicRule_vec_ref_t dynamic_rules_vec = DynamicRule_vec_end(&builder);
+        uint64_t key = hash_bytes((const char *)members, member_count * sizeof(uint64_t));
+        Segment *g = *segment_slot(cache, key, members, member_count);
+        if (!g) {
+            g = build_segment(cache, builder, props, &group, key, members, member_count);
+            built++;
+        }
+        if (g->generation != cache->generation) live++;
+        g->generation = cache->generation;
+        if (segment_count == segment_cap) {
+            segment_cap = segment_cap ? segment_cap * 2 : 256;
+            segments = realloc(segments, segment_cap * sizeof(Segment*));
+            CHECK(segments);
+        }
+        segments[segment_count++] = g;
+        *rule_count += group.count;
+        member_count = 0;
+        group.count = 0;
+    }
 
-    Styles_create_as_root(&builder, static_rules_vec, dynamic_rules_vec);
+    uint64_t names = hash_bytes((const char *)&all.count, sizeof(all.count));
+    for (size_t i = 0; i < all.count; i++) {
+        names = (names ^ hash_bytes(all.items[i]->name, strlen(all.items[i]->name))) * 1099511628211ULL;
+    }
+    if (!cache->index || names != cache->index_names) {
+        free(cache->index);
+        cache->index_len = 0;
+        cache->index = build_name_index(all.items, all.count, &cache->index_len);
+        cache->index_names = names;
+    }
 
+    long rc = write_segments(segments, segment_count, all.count, cache->index, cache->index_len, size_out) == 0 ? built : -1;
+    if (cache->used - live > live + 64) segment_cache_rebuild(cache, true, 0);
+    free(segments);
+    free(members);
+    free(group.items);
+    free(all.items);
+    return rc;
+}
+
+static double elapsed_ms(const struct timespec *since) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - since->tv_sec) * 1e3 + (now.tv_nsec - since->tv_nsec) / 1e6;
+}
+
+static void regenerate(const char *toml_path, SectionCache *cache, SegmentCache *segments, flatcc_builder_t *builder, PropCache *props, PropScratch *sc) {
+    struct timespec started;
+    clock_gettime(CLOCK_MONOTONIC, &started);
+
+    size_t len;
+    char *buf = read_file(toml_path, &len);
+    if (!buf) {
+        fprintf(stderr, "Error: Cannot open input file '%s'.\n", toml_path);
+        return;
+    }
+
+    SectionList order = {0};
+    long parsed = collect_sections(cache, buf, len, toml_path, sc, &order);
     size_t size;
-    void *buf = flatcc_builder_get_direct_buffer(&builder, &size);
-    
-    FILE *out = fopen("styles.bin", "wb");
-    if (!out) {
-        fprintf(stderr, "Error: Failed to open output file 'styles.bin' for writing.\n");
-        exit(1);
+    if (parsed >= 0) {
+        size_t rule_count;
+        long built = write_segmented(segments, &order, builder, props, &rule_count, &size);
+        if (built >= 0) {
+            printf("Regenerated '" OUTPUT_PATH "' in %.1f ms (%zu rules, %ld section(s) re-parsed, %ld segment(s) rebuilt, %zu bytes)\n",
+                   elapsed_ms(&started), rule_count, parsed, built, size);
+        }
+    } else {
+        // Full parse: either the document is valid as a whole (e.g. a
+        // multi-line string holding a '[' line) or this reports the error.
+        char errbuf[200];
+        toml_table_t *conf = toml_parse_n_arena(buf, len, errbuf, sizeof(errbuf));
+        if (!conf) {
+            fprintf(stderr, "Error parsing TOML file '%s': %s\n", toml_path, errbuf);
+        } else {
+            RuleList rules = {0};
+            if (compile_rules(conf, toml_path, sc, &rules) == 0 &&
+                write_styles(builder, props, rules.items, rules.count, &size) == 0) {
+                printf("Regenerated '" OUTPUT_PATH "' in %.1f ms (%zu rules, full parse, %zu bytes)\n",
+                       elapsed_ms(&started), rules.count, size);
+            }
+            rule_list_free(&rules);
+            free(rules.items);
+            toml_free(conf);
+        }
     }
-    fwrite(buf, 1, size, out);
-    fclose(out);
+    fflush(stdout);
+    free(order.items);
+    free(buf);
+}
 
-    printf("Successfully converted '%s' to 'styles.bin'\n", toml_path);
+static int watch(const char *toml_path, flatcc_builder_t *builder, PropCache *props) {
+    SectionCache cache = {0};
+    SegmentCache segments = {0};
+    PropScratch scratch = {0};
+    section_cache_rebuild(&cache, true, 0);
+    segment_cache_rebuild(&segments, true, 0);
 
-    toml_free(conf);
-    flatcc_builder_clear(&builder);
+    printf("Watching '%s' for changes...\n", toml_path);
+    struct stat seen = {0};
+    bool pending = false;
+    const struct timespec interval = { 0, WATCH_INTERVAL_MS * 1000000L };
+    for (;;) {
+        // Compare the inode too: editors commonly save by renaming a new
+        // file in. A change is only acted on once the file has stayed the
+        // same for one interval, so a save still in progress is not read.
+        struct stat st;
+        if (stat(toml_path, &st) == 0) {
+            bool changed = st.st_mtim.tv_sec != seen.st_mtim.tv_sec || st.st_mtim.tv_nsec != seen.st_mtim.tv_nsec ||
+                           st.st_size != seen.st_size || st.st_ino != seen.st_ino;
+            if (changed) {
+                seen = st;
+                pending = true;
+            } else if (pending) {
+                pending = false;
+                regenerate(toml_path, &cache, &segments, builder, props, &scratch);
+            }
+        }
+        nanosleep(&interval, NULL);
+    }
     return 0;
+}
+
+int main(int argc, char *argv[]) {
+    const char *toml_path = "styles.toml";
+    bool watch_mode = false;
+    long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--watch") == 0) watch_mode = true;
+        else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) jobs = strtol(argv[++i], NULL, 10);
+        else toml_path = argv[i];
+    }
+    if (jobs < 1) jobs = 1;
+    if (jobs > MAX_JOBS) jobs = MAX_JOBS;
+
+    flatcc_builder_t builder;
+    flatcc_builder_init(&builder);
+    // Property keys and common values repeat across nearly every rule.
+    CHECK(flatcc_builder_set_string_interning(&builder, 1) == 0);
+    PropCache prop_cache = {0};
+
+    int rc = watch_mode ? watch(toml_path, &builder, &prop_cache)
+                        : generate_once(toml_path, (int)jobs, &builder, &prop_cache);
+
+    free(prop_cache.slots);
+    flatcc_builder_clear(&builder);
+    return rc;
 }
\ No newline at end of file
@@ -35,6 +35,13 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__unix__) || defined(__APPLE__)
+#define TOML_HAVE_MMAP 1
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 static void *(*ppmalloc)(size_t) = malloc;
 static void (*ppfree)(void *) = free;
 
@@ -304,11 +311,25 @@ struct toml_array_t {
   toml_arritem_t *item;
 };
 
+typedef struct toml_keyslot_t toml_keyslot_t;
+struct toml_keyslot_t {
+  uint32_t hash;
+  int kind; /* 'v'alue, 'a'rray, 't'able, or 0 if the slot is empty */
+  int idx;  /* position in kval, arr or tab */
+};
+
 struct toml_table_t {
   const char *key; /* key to this table */
   bool implicit;   /* table was created implicitly */
   bool readonly;   /* no more modification allowed */
 
+  /* optional hash index over all keys, see index_build() */
+  int nslot; /* power of two, 0 if there is no index */
+  toml_keyslot_t *slot;
+
+  /* set on the root of a document parsed in arena mode */
+  struct toml_arena_t *arena;
+
   /* key-values in the table */
   int nkval;
   toml_keyval_t **kval;
@@ -419,8 +440,25 @@ static void *expand(void *p, int sz, int newsz) {
   return s;
 }
 
+/*
+ * Arrays holding n elements are sized to the next power of two, so the
+ * capacity is implied by n and only needs to grow when n is 0 or a power
+ * of two. This keeps appends amortized O(1) without storing a capacity.
+ */
+static int grow_capacity(int n) {
+  if (n & (n - 1))
+    return 0;
+  return n ? n * 2 : 1;
+}
+
 static void **expand_ptrarr(void **p, int n) {
-  void **s = MALLOC((n + 1) * sizeof(void *));
+  int cap = grow_capacity(n);
+  if (!cap) {
+    p[n] = 0;
+    return p;
+  }
+
+  void **s = MALLOC(cap * sizeof(void *));
   if (!s)
     return 0;
 
@@ -433,9 +471,13 @@ static void **expand_ptrarr(void **p, int n) {
 }
 
 static toml_arritem_t *expand_arritem(toml_arritem_t *p, int n) {
-  toml_arritem_t *pp = expand(p, n * sizeof(*p), (n + 1) * sizeof(*p));
-  if (!pp)
-    return 0;
+  int cap = grow_capacity(n);
+  toml_arritem_t *pp = p;
+  if (cap) {
+    pp = expand(p, n * sizeof(*p), cap * sizeof(*p));
+    if (!pp)
+      return 0;
+  }
 
   memset(&pp[n], 0, sizeof(pp[n]));
   return pp;
@@ -453,7 +495,7 @@ static char *norm_lit_str(const char *src, int srclen, int multiline,
   /* scan forward on src */
   for (;;) {
     if (off >= max - 10) { /* have some slack for misc stuff */
-      int newmax = max + 50;
+      int newmax = max ? max * 2 : 64;
       char *x = expand(dst, max, newmax);
       if (!x) {
         xfree(dst);
@@ -502,7 +544,7 @@ static char *norm_basic_str(const char *src, int srclen, int multiline,
   /* scan forward on src */
   for (;;) {
     if (off >= max - 10) { /* have some slack for misc stuff */
-      int newmax = max + 50;
+      int newmax = max ? max * 2 : 64;
       char *x = expand(dst, max, newmax);
       if (!x) {
         xfree(dst);
@@ -686,47 +728,172 @@ static char *normalize_key(context_t *ctx, token_t strtok) {
 }
 
 /*
- * Look up key in tab. Return 0 if not found, or
- * 'v'alue, 'a'rray or 't'able depending on the element.
+ * Tables that reach INDEX_THRESHOLD keys get an open-addressing hash index
+ * so that lookups and the duplicate check on every insert stop being
+ * linear scans. It is built from check_key() while parsing, so lookups on
+ * a finished document only ever read it. If the index cannot be allocated
+ * the table simply keeps using the linear scan.
  */
-static int check_key(toml_table_t *tab, const char *key,
-                     toml_keyval_t **ret_val, toml_array_t **ret_arr,
-                     toml_table_t **ret_tab) {
+#define INDEX_THRESHOLD 16
+
+static uint32_t hash_key(const char *key) {
+  uint32_t h = 2166136261u;
+  for (; *key; key++) {
+    h ^= (unsigned char)*key;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+static const char *slot_key(const toml_table_t *tab,
+                            const toml_keyslot_t *slot) {
+  switch (slot->kind) {
+  case 'v':
+    return tab->kval[slot->idx]->key;
+  case 'a':
+    return tab->arr[slot->idx]->key;
+  default:
+    return tab->tab[slot->idx]->key;
+  }
+}
+
+static void index_put(toml_keyslot_t *slot, int nslot, uint32_t hash,
+                      int kind, int idx) {
+  int i = hash & (nslot - 1);
+  while (slot[i].kind)
+    i = (i + 1) & (nslot - 1);
+  slot[i].hash = hash;
+  slot[i].kind = kind;
+  slot[i].idx = idx;
+}
+
+static void index_drop(toml_table_t *tab) {
+  xfree(tab->slot);
+  tab->slot = 0;
+  tab->nslot = 0;
+}
+
+/* Rebuild the index with room for at least n keys at <= 50% load. */
+static int index_build(toml_table_t *tab, int n) {
+  int nslot = 2 * INDEX_THRESHOLD;
+  while (nslot < 2 * n)
+    nslot *= 2;
+
+  toml_keyslot_t *slot = CALLOC(nslot, sizeof(*slot));
+  if (!slot) {
+    index_drop(tab);
+    return -1;
+  }
+
   int i;
-  void *dummy;
+  for (i = 0; i < tab->nkval; i++)
+    index_put(slot, nslot, hash_key(tab->kval[i]->key), 'v', i);
+  for (i = 0; i < tab->narr; i++)
+    index_put(slot, nslot, hash_key(tab->arr[i]->key), 'a', i);
+  for (i = 0; i < tab->ntab; i++)
+    index_put(slot, nslot, hash_key(tab->tab[i]->key), 't', i);
+
+  xfree(tab->slot);
+  tab->slot = slot;
+  tab->nslot = nslot;
+  return 0;
+}
 
-  if (!ret_tab)
-    ret_tab = (toml_table_t **)&dummy;
-  if (!ret_arr)
-    ret_arr = (toml_array_t **)&dummy;
-  if (!ret_val)
-    ret_val = (toml_keyval_t **)&dummy;
+/* Record a key just appended to kval, arr or tab. */
+static void index_add(toml_table_t *tab, int kind, int idx,
+                      const char *key) {
+  if (!tab->slot)
+    return;
 
-  *ret_tab = 0;
-  *ret_arr = 0;
-  *ret_val = 0;
+  int n = tab->nkval + tab->narr + tab->ntab;
+  if (2 * n > tab->nslot) {
+    /* the rebuild already picks up the new key */
+    index_build(tab, n);
+    return;
+  }
+  index_put(tab->slot, tab->nslot, hash_key(key), kind, idx);
+}
+
+/*
+ * Find key in tab. Return 0 if not found, or 'v'alue, 'a'rray or 't'able,
+ * with the element's position in *idx.
+ */
+static int find_key(const toml_table_t *tab, const char *key, int *idx) {
+  int i;
+
+  if (tab->slot) {
+    uint32_t hash = hash_key(key);
+    for (i = hash & (tab->nslot - 1); tab->slot[i].kind;
+         i = (i + 1) & (tab->nslot - 1)) {
+      const toml_keyslot_t *slot = &tab->slot[i];
+      if (slot->hash == hash && 0 == strcmp(key, slot_key(tab, slot))) {
+        *idx = slot->idx;
+        return slot->kind;
+      }
+    }
+    return 0;
+  }
 
   for (i = 0; i < tab->nkval; i++) {
     if (0 == strcmp(key, tab->kval[i]->key)) {
-      *ret_val = tab->kval[i];
+      *idx = i;
       return 'v';
     }
   }
   for (i = 0; i < tab->narr; i++) {
     if (0 == strcmp(key, tab->arr[i]->key)) {
-      *ret_arr = tab->arr[i];
+      *idx = i;
       return 'a';
     }
   }
   for (i = 0; i < tab->ntab; i++) {
     if (0 == strcmp(key, tab->tab[i]->key)) {
-      *ret_tab = tab->tab[i];
+      *idx = i;
       return 't';
     }
   }
   return 0;
 }
 
+/*
+ * Look up key in tab. Return 0 if not found, or
+ * 'v'alue, 'a'rray or 't'able depending on the element.
+ */
+static int check_key(toml_table_t *tab, const char *key,
+                     toml_keyval_t **ret_val, toml_array_t **ret_arr,
+                     toml_table_t **ret_tab) {
+  int idx;
+  void *dummy;
+
+  if (!ret_tab)
+    ret_tab = (toml_table_t **)&dummy;
+  if (!ret_arr)
+    ret_arr = (toml_array_t **)&dummy;
+  if (!ret_val)
+    ret_val = (toml_keyval_t **)&dummy;
+
+  *ret_tab = 0;
+  *ret_arr = 0;
+  *ret_val = 0;
+
+  if (!tab->slot && tab->nkval + tab->narr + tab->ntab >= INDEX_THRESHOLD)
+    index_build(tab, tab->nkval + tab->narr + tab->ntab);
+
+  int kind = find_key(tab, key, &idx);
+  switch (kind) {
+  case 'v':
+    *ret_val = tab->kval[idx];
+    break;
+  case 'a':
+    *ret_arr = tab->arr[idx];
+    break;
+  case 't':
+    *ret_tab = tab->tab[idx];
+    break;
+  }
+  return kind;
+}
+
 static int key_kind(toml_table_t *tab, const char *key) {
   return check_key(tab, key, 0, 0, 0);
 }
@@ -769,6 +936,7 @@ static toml_keyval_t *create_keyval_in_table(context_t *ctx, toml_table_t *tab,
 
   /* save the key in the new value struct */
   dest->key = newkey;
+  index_add(tab, 'v', n, newkey);
   return dest;
 }
 
@@ -817,6 +985,7 @@ static toml_table_t *create_keytable_in_table(context_t *ctx, toml_table_t *tab,
 
   /* save the key in the new table struct */
   dest->key = newkey;
+  index_add(tab, 't', n, newkey);
   return dest;
 }
 
@@ -858,6 +1027,7 @@ static toml_array_t *create_keyarray_in_table(context_t *ctx, toml_table_t *tab,
   /* save the key in the new array struct */
   dest->key = newkey;
   dest->kind = kind;
+  index_add(tab, 'a', n, newkey);
   return dest;
 }
 
@@ -1292,6 +1462,7 @@ static int walk_tabpath(context_t *ctx) {
         return e_outofmemory(ctx, FLINE);
 
       nexttab = curtab->tab[curtab->ntab++];
+      index_add(curtab, 't', n, nexttab->key);
 
       /* tabs created by walk_tabpath are considered implicit */
       nexttab->implicit = true;
@@ -1400,6 +1571,11 @@ static int parse_select(context_t *ctx) {
 }
 
 toml_table_t *toml_parse(char *conf, char *errbuf, int errbufsz) {
+  return toml_parse_n(conf, strlen(conf), errbuf, errbufsz);
+}
+
+toml_table_t *toml_parse_n(const char *conf, size_t len, char *errbuf,
+                           int errbufsz) {
   context_t ctx;
 
   // clear errbuf
@@ -1410,15 +1586,15 @@ toml_table_t *toml_parse(char *conf, char *errbuf, int errbufsz) {
 
   // init context
   memset(&ctx, 0, sizeof(ctx));
-  ctx.start = conf;
-  ctx.stop = ctx.start + strlen(conf);
+  ctx.start = (char *)(intptr_t)conf;
+  ctx.stop = ctx.start + len;
   ctx.errbuf = errbuf;
   ctx.errbufsz = errbufsz;
 
   // start with an artificial newline of length 0
   ctx.tok.tok = NEWLINE;
   ctx.tok.lineno = 1;
-  ctx.tok.ptr = conf;
+  ctx.tok.ptr = ctx.start;
   ctx.tok.len = 0;
 
   // make a root table
@@ -1477,57 +1653,209 @@ fail:
   return 0;
 }
 
-toml_table_t *toml_parse_file(FILE *fp, char *errbuf, int errbufsz) {
-  int bufsz = 0;
-  char *buf = 0;
-  int off = 0;
-
-  /* read from fp into buf */
-  while (!feof(fp)) {
-
-    if (off == bufsz) {
-      int xsz = bufsz + 1000;
-      char *x = expand(buf, bufsz, xsz);
-      if (!x) {
-        snprintf(errbuf, errbufsz, "out of memory");
-        xfree(buf);
-        return 0;
-      }
-      buf = x;
-      bufsz = xsz;
-    }
+/*
+ * Read the rest of fp into a NUL terminated buffer. The buffer is sized
+ * from fstat when possible so a regular file costs a single read; it
+ * grows geometrically for pipes or files that grow while being read.
+ */
+static char *read_stream(FILE *fp, size_t sizehint, size_t *len,
+                         char *errbuf, int errbufsz) {
+  size_t bufsz = sizehint ? sizehint + 1 : 4096;
+  size_t off = 0;
+  char *buf = MALLOC(bufsz);
+  if (!buf) {
+    snprintf(errbuf, errbufsz, "out of memory");
+    return 0;
+  }
 
+  for (;;) {
     errno = 0;
-    int n = fread(buf + off, 1, bufsz - off, fp);
+    off += fread(buf + off, 1, bufsz - off - 1, fp);
     if (ferror(fp)) {
       snprintf(errbuf, errbufsz, "%s",
                errno ? strerror(errno) : "Error reading file");
       xfree(buf);
       return 0;
     }
-    off += n;
-  }
+    if (off < bufsz - 1)
+      break;
 
-  /* tag on a NUL to cap the string */
-  if (off == bufsz) {
-    int xsz = bufsz + 1;
-    char *x = expand(buf, bufsz, xsz);
+    /* buffer is full: only grow it if there is more to read */
+    int ch = fgetc(fp);
+    if (ch == EOF) {
+      if (ferror(fp)) {
+        snprintf(errbuf, errbufsz, "Error reading file");
+        xfree(buf);
+        return 0;
+      }
+      break;
+    }
+    char *x = expand(buf, off, bufsz * 2);
     if (!x) {
       snprintf(errbuf, errbufsz, "out of memory");
       xfree(buf);
       return 0;
     }
     buf = x;
-    bufsz = xsz;
+    bufsz *= 2;
+    buf[off++] = (char)ch;
   }
+
   buf[off] = 0;
+  *len = off;
+  return buf;
+}
+
+typedef toml_table_t *(*parse_fn_t)(const char *, size_t, char *, int);
+
+static toml_table_t *parse_file(FILE *fp, char *errbuf, int errbufsz,
+                                parse_fn_t parse) {
+  size_t sizehint = 0;
+
+#ifdef TOML_HAVE_MMAP
+  /* A regular file that does not end on a page boundary is mapped and
+   * parsed in place. The NUL the scanner needs is written past EOF in the
+   * last page, which makes that page a private copy: a file that grows
+   * afterwards cannot replace the sentinel. A file whose size or mtime
+   * changed by the time it is mapped (a save truncating it would make
+   * pages past the new EOF raise SIGBUS) is read through the stream.
+   */
+  struct stat st, st2;
+  int fd = fileno(fp);
+  if (fd >= 0 && 0 == fstat(fd, &st) && S_ISREG(st.st_mode) &&
+      st.st_size > 0) {
+    long pagesz = sysconf(_SC_PAGESIZE);
+    size_t size = (size_t)st.st_size;
+    sizehint = size;
+    if (pagesz > 0 && size % pagesz != 0 && 0 == ftello(fp)) {
+      char *map = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+      if (map != MAP_FAILED) {
+        if (0 == fstat(fd, &st2) && st2.st_size == st.st_size &&
+            st2.st_mtime == st.st_mtime) {
+          map[size] = 0;
+          toml_table_t *ret = parse(map, size, errbuf, errbufsz);
+          munmap(map, size);
+          return ret;
+        }
+        munmap(map, size);
+      }
+    }
+  }
+#endif
+
+  size_t len;
+  char *buf = read_stream(fp, sizehint, &len, errbuf, errbufsz);
+  if (!buf)
+    return 0;
 
   /* parse it, cleanup and finish */
-  toml_table_t *ret = toml_parse(buf, errbuf, errbufsz);
+  toml_table_t *ret = parse(buf, len, errbuf, errbufsz);
   xfree(buf);
   return ret;
 }
 
+toml_table_t *toml_parse_file(FILE *fp, char *errbuf, int errbufsz) {
+  return parse_file(fp, errbuf, errbufsz, toml_parse_n);
+}
+
+/*
+ * Arena mode. While an arena document is parsed, MALLOC/FREE are pointed
+ * (as with toml_set_memutil) at a bump allocator whose chunks belong to
+ * the document, so parsing does no per-node malloc and toml_free releases
+ * the whole document by dropping its chunks. FREE of arena memory is a
+ * no-op; the geometric growth of arrays and strings bounds that waste.
+ */
+#define ARENA_CHUNK_SIZE (64 * 1024)
+
+typedef struct toml_arena_chunk_t toml_arena_chunk_t;
+struct toml_arena_chunk_t {
+  toml_arena_chunk_t *next;
+  size_t used;
+  size_t cap;
+  /* data follows, 8-byte aligned */
+};
+
+typedef struct toml_arena_t toml_arena_t;
+struct toml_arena_t {
+  toml_arena_chunk_t *head;
+  void *(*chunk_malloc)(size_t);
+  void (*chunk_free)(void *);
+};
+
+static toml_arena_t *cur_arena;
+
+static void *arena_malloc(size_t sz) {
+  toml_arena_t *a = cur_arena;
+  toml_arena_chunk_t *c = a->head;
+  sz = ALIGN8(sz);
+
+  if (!c || c->cap - c->used < sz) {
+    /* big requests get a chunk of their own behind the current one */
+    size_t cap = sz > ARENA_CHUNK_SIZE / 4 ? sz : ARENA_CHUNK_SIZE;
+    toml_arena_chunk_t *n =
+        a->chunk_malloc(ALIGN8(sizeof(toml_arena_chunk_t)) + cap);
+    if (!n)
+      return 0;
+    n->used = 0;
+    n->cap = cap;
+    if (c && cap != ARENA_CHUNK_SIZE) {
+      n->next = c->next;
+      c->next = n;
+    } else {
+      n->next = c;
+      a->head = n;
+    }
+    c = n;
+  }
+
+  void *p = (char *)c + ALIGN8(sizeof(toml_arena_chunk_t)) + c->used;
+  c->used += sz;
+  return p;
+}
+
+static void arena_free(void *p) { (void)p; }
+
+static void arena_release(toml_arena_t *a) {
+  toml_arena_chunk_t *c = a->head;
+  while (c) {
+    toml_arena_chunk_t *next = c->next;
+    a->chunk_free(c);
+    c = next;
+  }
+  a->chunk_free(a);
+}
+
+toml_table_t *toml_parse_n_arena(const char *conf, size_t len, char *errbuf,
+                                 int errbufsz) {
+  toml_arena_t *a = MALLOC(sizeof(*a));
+  if (!a) {
+    snprintf(errbuf, errbufsz, "out of memory");
+    return 0;
+  }
+  a->head = 0;
+  a->chunk_malloc = ppmalloc;
+  a->chunk_free = ppfree;
+
+  cur_arena = a;
+  ppmalloc = arena_malloc;
+  ppfree = arena_free;
+  toml_table_t *ret = toml_parse_n(conf, len, errbuf, errbufsz);
+  ppmalloc = a->chunk_malloc;
+  ppfree = a->chunk_free;
+  cur_arena = 0;
+
+  if (!ret) {
+    arena_release(a);
+    return 0;
+  }
+  ret->arena = a;
+  return ret;
+}
+
+toml_table_t *toml_parse_file_arena(FILE *fp, char *errbuf, int errbufsz) {
+  return parse_file(fp, errbuf, errbufsz, toml_parse_n_arena);
+}
+
 static void xfree_kval(toml_keyval_t *p) {
   if (!p)
     return;
@@ -1577,10 +1905,16 @@ static void xfree_tab(toml_table_t *p) {
     xfree_tab(p->tab[i]);
   xfree(p->tab);
 
+  xfree(p->slot);
   xfree(p);
 }
 
-void toml_free(toml_table_t *tab) { xfree_tab(tab); }
+void toml_free(toml_table_t *tab) {
+  if (tab && tab->arena)
+    arena_release(tab->arena);
+  else
+    xfree_tab(tab);
+}
 
 static void set_token(context_t *ctx, tokentype_t tok, int lineno, char *ptr,
                       int len) {
@@ -1878,47 +2212,23 @@ const char *toml_key_in(const toml_table_t *tab, int keyidx) {
 }
 
 int toml_key_exists(const toml_table_t *tab, const char *key) {
-  int i;
-  for (i = 0; i < tab->nkval; i++) {
-    if (0 == strcmp(key, tab->kval[i]->key))
-      return 1;
-  }
-  for (i = 0; i < tab->narr; i++) {
-    if (0 == strcmp(key, tab->arr[i]->key))
-      return 1;
-  }
-  for (i = 0; i < tab->ntab; i++) {
-    if (0 == strcmp(key, tab->tab[i]->key))
-      return 1;
-  }
-  return 0;
+  int idx;
+  return find_key(tab, key, &idx) ? 1 : 0;
 }
 
 toml_raw_t toml_raw_in(const toml_table_t *tab, const char *key) {
-  int i;
-  for (i = 0; i < tab->nkval; i++) {
-    if (0 == strcmp(key, tab->kval[i]->key))
-      return tab->kval[i]->val;
-  }
-  return 0;
+  int idx;
+  return find_key(tab, key, &idx) == 'v' ? tab->kval[idx]->val : 0;
 }
 
 toml_array_t *toml_array_in(const toml_table_t *tab, const char *key) {
-  int i;
-  for (i = 0; i < tab->narr; i++) {
-    if (0 == strcmp(key, tab->arr[i]->key))
-      return tab->arr[i];
-  }
-  return 0;
+  int idx;
+  return find_key(tab, key, &idx) == 'a' ? tab->arr[idx] : 0;
 }
 
 toml_table_t *toml_table_in(const toml_table_t *tab, const char *key) {
-  int i;
-  for (i = 0; i < tab->ntab; i++) {
-    if (0 == strcmp(key, tab->tab[i]->key))
-      return tab->tab[i];
-  }
-  return 0;
+  int idx;
+  return find_key(tab, key, &idx) == 't' ? tab->tab[idx] : 0;
 }
 
 toml_raw_t toml_raw_at(const toml_array_t *arr, int idx) {
@@ -1961,6 +2271,10 @@ toml_table_t *toml_table_at(const toml_array_t *arr, int idx) {
   return (0 <= idx && idx < arr->nitem) ? arr->item[idx].tab : 0;
 }
 
+toml_table_t *toml_table_tab_at(const toml_table_t *tab, int idx) {
+  return (0 <= idx && idx < tab->ntab) ? tab->tab[idx] : 0;
+}
+
 static int parse_millisec(const char *p, const char **endp);
 
 int toml_rtots(toml_raw_t src_, toml_timestamp_t *ret) {
@@ -2330,6 +2644,48 @@ toml_datum_t toml_string_in(const toml_table_t *arr, const char *key) {
   return ret;
 }
 
+int toml_string_kval_view(const toml_table_t *tab, int idx, const char **key,
+                          const char **ptr, int *len) {
+  if (idx < 0 || idx >= tab->nkval)
+    return -1;
+
+  const char *raw = tab->kval[idx]->val;
+  char quote = raw[0];
+  if (quote != '\'' && quote != '"')
+    return -1;
+
+  /* only single-line strings that need no unescaping can be borrowed */
+  const char *p = raw + 1;
+  for (; *p && *p != quote; p++) {
+    int ch = (unsigned char)*p;
+    if ((ch == '\\' && quote == '"') || (ch <= 0x1f && ch != '\t') ||
+        ch == 0x7f)
+      return -1;
+  }
+  if (p == raw + 1 && p[1] == quote)
+    return -1; /* opens a multi-line string */
+  if (*p != quote || p[1])
+    return -1;
+
+  if (key)
+    *key = tab->kval[idx]->key;
+  *ptr = raw + 1;
+  *len = (int)(p - raw - 1);
+  return 0;
+}
+
+toml_datum_t toml_string_kval_at(const toml_table_t *tab, int idx,
+                                 const char **key) {
+  toml_datum_t ret;
+  memset(&ret, 0, sizeof(ret));
+  if (0 <= idx && idx < tab->nkval) {
+    if (key)
+      *key = tab->kval[idx]->key;
+    ret.ok = (0 == toml_rtos(tab->kval[idx]->val, &ret.u.s));
+  }
+  return ret;
+}
+
 toml_datum_t toml_bool_in(const toml_table_t *arr, const char *key) {
   toml_datum_t ret;
   memset(&ret, 0, sizeof(ret));
@@ -55,6 +55,25 @@ TOML_EXTERN toml_table_t *toml_parse_file(FILE *fp, char *errbuf, int errbufsz);
 TOML_EXTERN toml_table_t *toml_parse(char *conf, /* NUL terminated, please. */
                                      char *errbuf, int errbufsz);
 
+/* Parse the first len bytes of conf in place, without copying it.
+ * conf[len] must be readable and NUL: the scanner uses it as a sentinel.
+ * Both a C string and a mapping of a file that does not end on a page
+ * boundary satisfy this.
+ */
+TOML_EXTERN toml_table_t *toml_parse_n(const char *conf, size_t len,
+                                       char *errbuf, int errbufsz);
+
+/* Arena mode: like toml_parse_file() and toml_parse_n(), but every node
+ * and string of the document is carved from chunks the document owns, and
+ * toml_free() releases them in one go. Call toml_free() only on the root.
+ * The chunks come from the allocator set by toml_set_memutil(), which is
+ * swapped out while parsing, so do not parse from several threads.
+ */
+TOML_EXTERN toml_table_t *toml_parse_file_arena(FILE *fp, char *errbuf,
+                                                int errbufsz);
+TOML_EXTERN toml_table_t *toml_parse_n_arena(const char *conf, size_t len,
+                                             char *errbuf, int errbufsz);
+
 /* Free the table returned by toml_parse() or toml_parse_file(). Once
  * this function is called, any handles accessed through this tab
  * directly or indirectly are no longer valid.
@@ -122,6 +141,17 @@ TOML_EXTERN toml_array_t *toml_array_in(const toml_table_t *tab,
                                         const char *key);
 TOML_EXTERN toml_table_t *toml_table_in(const toml_table_t *tab,
                                         const char *key);
+/* ... retrieve by position, without a key lookup. idx ranges over
+   [0, toml_table_nkval) and [0, toml_table_ntab) respectively. */
+TOML_EXTERN toml_datum_t toml_string_kval_at(const toml_table_t *tab, int idx,
+                                             const char **key);
+TOML_EXTERN toml_table_t *toml_table_tab_at(const toml_table_t *tab, int idx);
+/* ... borrow the string at idx without copying. Returns 0 and sets ptr/len
+   (not NUL terminated, valid until toml_free) for a single-line string that
+   needs no unescaping, -1 otherwise: fall back to toml_string_kval_at. */
+TOML_EXTERN int toml_string_kval_view(const toml_table_t *tab, int idx,
+                                      const char **key, const char **ptr,
+                                      int *len);
 
 /*-----------------------------------------------------------------
  * lesser used
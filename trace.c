@@ -0,0 +1,184 @@
+#include "trace.h"
+#include "utils.h"
+#include "file_io.h"
+
+// Log-linear buckets in the spirit of HdrHistogram: 16 linear sub-buckets per
+// power of two keeps every recorded latency within 1/16 (6.25%) of its value.
+#define HISTOGRAM_SUB_BITS 4
+#define HISTOGRAM_SUB_COUNT (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_BUCKETS ((64 - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_COUNT)
+#define MAX_TRACE_EVENTS (1 << 20)
+
+typedef struct {
+    uint64_t buckets[HISTOGRAM_BUCKETS];
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint64_t files;
+    uint64_t bytes;
+} Histogram;
+
+typedef struct {
+    uint8_t phase;
+    uint64_t start;
+    uint64_t duration;
+    uint64_t files;
+    uint64_t bytes;
+} TraceEvent;
+
+static const char* phase_names[TRACE_PHASE_COUNT] = {
+    "cycle", "scandir", "read", "verify", "parse", "id-alloc", "rewrite", "collect", "css-emit", "write"
+};
+
+static bool tracing_active = false;
+static bool stats_requested = false;
+static char* trace_file_path = NULL;
+static uint64_t trace_origin = 0;
+static Histogram histograms[TRACE_PHASE_COUNT];
+static TraceEvent* events = NULL;
+static size_t event_count = 0;
+static size_t event_capacity = 0;
+static size_t events_dropped = 0;
+
+static size_t bucket_index(uint64_t value) {
+    if (value < HISTOGRAM_SUB_COUNT) return (size_t)value;
+    int msb = 63 - __builtin_clzll(value);
+    int shift = msb - HISTOGRAM_SUB_BITS;
+    return (size_t)(shift + 1) * HISTOGRAM_SUB_COUNT + (size_t)((value >> shift) - HISTOGRAM_SUB_COUNT);
+}
+
+static uint64_t bucket_value(size_t index) {
+    if (index < HISTOGRAM_SUB_COUNT) return index;
+    int shift = (int)(index / HISTOGRAM_SUB_COUNT) - 1;
+    uint64_t sub = index % HISTOGRAM_SUB_COUNT;
+    return (HISTOGRAM_SUB_COUNT + sub) << shift;
+}
+
+static uint64_t histogram_percentile(const Histogram* h, double percentile) {
+    if (h->count == 0) return 0;
+    uint64_t target = (uint64_t)(h->count * percentile / 100.0 + 0.5);
+    if (target == 0) target = 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        seen += h->buckets[i];
+        if (seen >= target) return bucket_value(i);
+    }
+    return h->max_ns;
+}
+
+void trace_init(bool collect_stats, const char* trace_path) {
+    stats_requested = collect_stats;
+    tracing_active = collect_stats || trace_path;
+    trace_origin = uv_hrtime();
+    if (trace_path) {
+        trace_file_path = strdup(trace_path);
+        CHECK(trace_file_path);
+    }
+}
+
+bool trace_enabled(void) {
+    return tracing_active;
+}
+
+uint64_t trace_begin(void) {
+    return tracing_active ? uv_hrtime() : 0;
+}
+
+void trace_record(TracePhase phase, uint64_t start, uint64_t duration_ns, size_t files, size_t bytes) {
+    if (!tracing_active) return;
+
+    Histogram* h = &histograms[phase];
+    h->buckets[bucket_index(duration_ns)]++;
+    h->count++;
+    h->total_ns += duration_ns;
+    if (duration_ns > h->max_ns) h->max_ns = duration_ns;
+    h->files += files;
+    h->bytes += bytes;
+
+    if (!trace_file_path) return;
+    if (event_count >= event_capacity) {
+        if (event_capacity >= MAX_TRACE_EVENTS) {
+            events_dropped++;
+            return;
+        }
+        event_capacity = event_capacity == 0 ? 1024 : event_capacity * 2;
+        events = realloc(events, event_capacity * sizeof(TraceEvent));
+        CHECK(events);
+    }
+    events[event_count++] = (TraceEvent){ (uint8_t)phase, start, duration_ns, files, bytes };
+}
+
+void trace_end(TracePhase phase, uint64_t start, size_t files, size_t bytes) {
+    if (!tracing_active) return;
+    trace_record(phase, start, uv_hrtime() - start, files, bytes);
+}
+
+void trace_format_stats(StringBuilder* sb) {
+    char line[256];
+    snprintf(line, sizeof(line), "%-9s %8s %10s %10s %10s %10s %10s %8s %12s\n",
+             "phase", "count", "mean(us)", "p50(us)", "p90(us)", "p99(us)", "max(us)", "files", "bytes");
+    sb_append_str(sb, line);
+
+    for (int i = 0; i < TRACE_PHASE_COUNT; i++) {
+        const Histogram* h = &histograms[i];
+        if (h->count == 0) continue;
+        snprintf(line, sizeof(line), "%-9s %8llu %10.1f %10.1f %10.1f %10.1f %10.1f %8llu %12llu\n",
+                 phase_names[i], (unsigned long long)h->count,
+                 h->total_ns / 1e3 / h->count,
+                 histogram_percentile(h, 50.0) / 1e3,
+                 histogram_percentile(h, 90.0) / 1e3,
+                 histogram_percentile(h, 99.0) / 1e3,
+                 h->max_ns / 1e3,
+                 (unsigned long long)h->files, (unsigned long long)h->bytes);
+        sb_append_str(sb, line);
+    }
+
+    const DiffWriteStats* outputs = file_io_output_stats();
+    if (outputs->written + outputs->skipped + outputs->failed > 0) {
+        snprintf(line, sizeof(line), "outputs: %zu written, %zu unchanged, %zu failed (%zu bytes written)\n",
+                 outputs->written, outputs->skipped, outputs->failed, outputs->bytes_written);
+        sb_append_str(sb, line);
+    }
+}
+
+static void write_chrome_trace(const char* path) {
+    FILE* fp = fopen(path, "w");
+    if (!fp) {
+        fprintf(stderr, "%sCould not write trace to '%s'%s\n", KRED, path, KNRM);
+        return;
+    }
+
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", fp);
+    for (size_t i = 0; i < event_count; i++) {
+        const TraceEvent* e = &events[i];
+        fprintf(fp, "%s{\"name\":\"%s\",\"cat\":\"dx-styles\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+                    "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"files\":%llu,\"bytes\":%llu}}",
+                i == 0 ? "" : ",\n", phase_names[e->phase],
+                (e->start - trace_origin) / 1e3, e->duration / 1e3,
+                (unsigned long long)e->files, (unsigned long long)e->bytes);
+    }
+    fprintf(fp, "\n],\"otherData\":{\"dropped_events\":%zu}}\n", events_dropped);
+    fclose(fp);
+}
+
+void trace_shutdown(void) {
+    if (!tracing_active) return;
+
+    if (stats_requested) {
+        StringBuilder sb;
+        sb_init(&sb, 2048);
+        trace_format_stats(&sb);
+        fputs(sb.buffer, stdout);
+        sb_free(&sb);
+    }
+    if (trace_file_path) {
+        write_chrome_trace(trace_file_path);
+        free(trace_file_path);
+        trace_file_path = NULL;
+    }
+
+    free(events);
+    events = NULL;
+    event_count = event_capacity = 0;
+    tracing_active = false;
+}
\ No newline at end of file
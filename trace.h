@@ -0,0 +1,32 @@
+#ifndef DX_TRACE_H
+#define DX_TRACE_H
+
+#include "common.h"
+
+typedef enum {
+    TRACE_CYCLE,
+    TRACE_SCANDIR,
+    TRACE_READ,
+    TRACE_VERIFY,
+    TRACE_PARSE,
+    TRACE_ID_ALLOC,
+    TRACE_REWRITE,
+    TRACE_COLLECT,
+    TRACE_CSS_EMIT,
+    TRACE_WRITE,
+    TRACE_PHASE_COUNT
+} TracePhase;
+
+// Tracing is off until trace_init() enables it; trace_begin()/trace_end() are
+// then a uv_hrtime() call and a histogram bump. `trace_path` additionally
+// records every span for a Chrome trace-event JSON export (chrome://tracing,
+// Perfetto) written by trace_shutdown().
+void trace_init(bool collect_stats, const char* trace_path);
+bool trace_enabled(void);
+uint64_t trace_begin(void);
+void trace_end(TracePhase phase, uint64_t start, size_t files, size_t bytes);
+void trace_record(TracePhase phase, uint64_t start, uint64_t duration_ns, size_t files, size_t bytes);
+void trace_format_stats(StringBuilder* sb);
+void trace_shutdown(void);
+
+#endif
\ No newline at end of file
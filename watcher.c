@@ -4,141 +4,235 @@
 #include "file_io.h"
 #include "utils.h"
 #include "id_generator.h"
+#include "file_index.h"
+#include "trace.h"
+#include "dir_watch.h"
+#include "read_pipeline.h"
+
+#define MAX_CYCLE_LISTENERS 4
 
 static uv_timer_t debounce_timer;
 static char* last_changed_file = NULL;
+// Components saved or removed since the last cycle; a directory event asks
+// for a full rescan instead.
+static FileList changed_files = {0};
+static bool rescan_pending = false;
 static DataLists previous_data = {0};
-static uv_fs_event_t fs_event;
+static FileIndex file_index = {0};
+static void* styles_buffer = NULL;
+static char styles_identity[128];
+static cycle_listener_cb cycle_listeners[MAX_CYCLE_LISTENERS];
+static size_t cycle_listener_count = 0;
 
 static void on_debounce_timeout(uv_timer_t *handle);
-static void on_file_change(uv_fs_event_t *handle, const char *filename, int events, int status);
+static void on_file_change(const char* path, int events);
 
-void run_modification_cycle(const char* trigger_file) {
-    uint64_t cycle_start_time = uv_hrtime();
-    UsedIdNode* used_ids_head = NULL;
+static void* scan_file(const char* source, size_t size) {
+    return parser_scan_buffer(source, size);
+}
+
+// Files the pipeline did not buffer (unreadable, or large enough to stream
+// under --memory-budget) go through the path-based parser entry points.
+static void on_file_read(const char* path, char* source, size_t size, void* plan, void* ctx) {
+    UsedIdNode** used_ids_head = ctx;
+    if (!source) {
+        process_file(path, used_ids_head);
+        file_index_update(&file_index, path);
+        return;
+    }
+    parser_apply_plan(path, &source, &size, plan, used_ids_head);
+    tag_plan_free(plan);
+    uint64_t span = trace_begin();
+    file_index_update_buffer(&file_index, path, source, size);
+    trace_end(TRACE_COLLECT, span, 1, size);
+    free(source);
+}
+
+// styles.bin is only read again once its identity (see load_styles_buffer)
+// has changed.
+static bool refresh_styles_buffer(void) {
+    char identity[sizeof(styles_identity)];
+    int identity_len = file_path_identity("styles.bin", identity, sizeof(identity));
+    if (styles_buffer && identity_len > 0 && strcmp(identity, styles_identity) == 0) return true;
 
     size_t styles_bin_size;
-    void* styles_buffer = map_file_read("styles.bin", &styles_bin_size);
-    if (!styles_buffer) {
+    void* new_styles_buffer = load_styles_buffer("styles.bin", &styles_bin_size);
+    if (new_styles_buffer) {
+        free(styles_buffer);
+        styles_buffer = new_styles_buffer;
+        snprintf(styles_identity, sizeof(styles_identity), "%s", identity_len > 0 ? identity : "");
+    } else if (styles_buffer) {
+        fprintf(stderr, "Could not load styles.bin, keeping the previous styles\n");
+    } else {
         fprintf(stderr, "Could not load styles.bin\n");
-        return;
+        return false;
     }
+    return true;
+}
 
-    FileList file_list = {0};
-    file_list.capacity = 16;
-    file_list.paths = malloc(file_list.capacity * sizeof(char*));
-    CHECK(file_list.paths);
-
-    uv_fs_t scan_req;
-    uv_fs_scandir(NULL, &scan_req, "./src", 0, NULL);
-    uv_dirent_t dirent;
-    while (UV_EOF != uv_fs_scandir_next(&scan_req, &dirent)) {
-        if (dirent.type == UV_DIRENT_FILE && strstr(dirent.name, ".tsx")) {
-            if (file_list.count >= file_list.capacity) {
-                file_list.capacity *= 2;
-                file_list.paths = realloc(file_list.paths, file_list.capacity * sizeof(char*));
-                CHECK(file_list.paths);
-            }
-            char full_path[512];
-            snprintf(full_path, sizeof(full_path), "./src/%s", dirent.name);
-            file_list.paths[file_list.count++] = strdup(full_path);
-        }
+static bool is_regular_file(const char* path) {
+    uv_fs_t req;
+    bool regular = uv_fs_stat(NULL, &req, path, NULL) == 0 && (req.statbuf.st_mode & S_IFMT) == S_IFREG;
+    uv_fs_req_cleanup(&req);
+    return regular;
+}
+
+// Re-reads `paths` (sorted, no duplicates) and drops the ones that are gone.
+// Ids are unique across the tree, so every id the index holds for the other
+// files is taken before the changed files get theirs.
+static size_t update_changed_files(char** paths, size_t count, UsedIdNode** used_ids_head) {
+    for (size_t i = 0; i < file_index.count; i++) {
+        const FileIndexEntry* entry = &file_index.entries[i];
+        if (bsearch(&entry->path, paths, count, sizeof(char*), compare_strings)) continue;
+        for (size_t j = 0; j < entry->data.id_count; j++) reserve_id(used_ids_head, entry->data.injected_ids[j]);
+    }
+
+    char** present = malloc((count ? count : 1) * sizeof(char*));
+    CHECK(present);
+    size_t present_count = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (is_regular_file(paths[i])) present[present_count++] = paths[i];
+        else file_index_remove(&file_index, paths[i]);
     }
-    uv_fs_req_cleanup(&scan_req);
+    read_pipeline_run(present, present_count, parser_streams_size, scan_file, on_file_read, used_ids_head);
+    free(present);
+    return present_count;
+}
 
-    qsort(file_list.paths, file_list.count, sizeof(char*), compare_strings);
+// `changed` limits the cycle to those files; NULL rescans ./src.
+static void run_cycle(const char* trigger_file, FileList* changed) {
+    uint64_t cycle_start_time = uv_hrtime();
+    UsedIdNode* used_ids_head = NULL;
+    if (!refresh_styles_buffer()) return;
+
+    size_t file_count;
+    uint64_t span;
+    if (changed) {
+        qsort(changed->paths, changed->count, sizeof(char*), compare_strings);
+        size_t unique = 0;
+        for (size_t i = 0; i < changed->count; i++) {
+            if (unique > 0 && strcmp(changed->paths[unique - 1], changed->paths[i]) == 0) free(changed->paths[i]);
+            else changed->paths[unique++] = changed->paths[i];
+        }
+        changed->count = unique;
+        file_count = update_changed_files(changed->paths, changed->count, &used_ids_head);
+        span = trace_begin();
+    } else {
+        span = trace_begin();
+        FileList file_list = {0};
+        collect_source_files(&file_list, "./src", ".tsx");
 
-    for (size_t i = 0; i < file_list.count; i++) {
-        process_file(file_list.paths[i], &used_ids_head);
+        qsort(file_list.paths, file_list.count, sizeof(char*), compare_strings);
+        trace_end(TRACE_SCANDIR, span, file_list.count, 0);
+
+        read_pipeline_run(file_list.paths, file_list.count, parser_streams_size, scan_file,
+                          on_file_read, &used_ids_head);
+
+        span = trace_begin();
+        file_index_retain(&file_index, &file_list);
+        file_count = file_list.count;
+        free_file_list(&file_list);
     }
-    
-    free_file_list(&file_list);
 
     DataLists current_data;
-    collect_data(&current_data, "./src");
+    file_index_merge(&file_index, &current_data);
+    trace_end(TRACE_COLLECT, span, 0, 0);
     write_final_css("styles.css", &current_data, styles_buffer);
 
     if (trigger_file) {
-        int ids_added = 0, ids_removed = 0;
-        int classes_added = 0, classes_removed = 0;
-
-        for (size_t i = 0; i < current_data.id_count; i++) {
-            bool found = false;
-            for (size_t j = 0; j < previous_data.id_count; j++) {
-                if (strcmp(current_data.injected_ids[i], previous_data.injected_ids[j]) == 0) {
-                    found = true; break;
-                }
-            }
-            if (!found) ids_added++;
-        }
-        for (size_t i = 0; i < previous_data.id_count; i++) {
-            bool found = false;
-            for (size_t j = 0; j < current_data.id_count; j++) {
-                if (strcmp(previous_data.injected_ids[i], current_data.injected_ids[j]) == 0) {
-                    found = true; break;
-                }
-            }
-            if (!found) ids_removed++;
-        }
-        for (size_t i = 0; i < current_data.class_count; i++) {
-            bool found = false;
-            for (size_t j = 0; j < previous_data.class_count; j++) {
-                if (strcmp(current_data.class_names[i], previous_data.class_names[j]) == 0) {
-                    found = true; break;
-                }
-            }
-            if (!found) classes_added++;
-        }
-        for (size_t i = 0; i < previous_data.class_count; i++) {
-            bool found = false;
-            for (size_t j = 0; j < current_data.class_count; j++) {
-                if (strcmp(previous_data.class_names[i], current_data.class_names[j]) == 0) {
-                    found = true; break;
-                }
-            }
-            if (!found) classes_removed++;
-        }
+        DataLists added, removed;
+        data_lists_diff(&previous_data, &current_data, &added, &removed);
 
         double total_ms = (uv_hrtime() - cycle_start_time) / 1e6;
-        if (ids_added > 0 || ids_removed > 0 || classes_added > 0 || classes_removed > 0) {
-            printf("%s%s%s (%s+%d%s,%s-%d%s) -> %sstyles.css%s (%s+%d%s,%s-%d%s) • %.2fms\n",
+        if (added.id_count > 0 || removed.id_count > 0 || added.class_count > 0 || removed.class_count > 0) {
+            printf("%s%s%s (%s+%zu%s,%s-%zu%s) -> %sstyles.css%s (%s+%zu%s,%s-%zu%s) • %.2fms\n",
                    KMAG, trigger_file, KNRM,
-                   KGRN, ids_added, KNRM, KRED, ids_removed, KNRM,
+                   KGRN, added.id_count, KNRM, KRED, removed.id_count, KNRM,
                    KBCYN, KNRM,
-                   KGRN, classes_added, KNRM, KRED, classes_removed, KNRM,
+                   KGRN, added.class_count, KNRM, KRED, removed.class_count, KNRM,
                    total_ms);
+
+            for (size_t i = 0; i < cycle_listener_count; i++) {
+                cycle_listeners[i](trigger_file, &added, &removed);
+            }
         }
+
+        free_data_contents(&added);
+        free_data_contents(&removed);
     }
     
     free_data_contents(&previous_data);
     previous_data = current_data;
 
     free_used_id_list(&used_ids_head);
-    free(styles_buffer);
+    trace_end(TRACE_CYCLE, cycle_start_time, file_count, 0);
+}
+
+void run_modification_cycle(const char* trigger_file) {
+    run_cycle(trigger_file, NULL);
+}
+
+void run_changed_files_cycle(const char* trigger_file, FileList* changed) {
+    run_cycle(trigger_file, changed);
+}
+
+const DataLists* watcher_current_data(void) {
+    return &previous_data;
+}
+
+const DataLists* watcher_file_data(const char* path) {
+    return file_index_find(&file_index, path);
+}
+
+const void* watcher_styles_buffer(void) {
+    return styles_buffer;
+}
+
+void watcher_add_listener(cycle_listener_cb cb) {
+    CHECK(cycle_listener_count < MAX_CYCLE_LISTENERS);
+    cycle_listeners[cycle_listener_count++] = cb;
 }
 
 static void on_debounce_timeout(uv_timer_t *handle) {
     if (last_changed_file) {
-        run_modification_cycle(last_changed_file);
+        run_cycle(last_changed_file, rescan_pending ? NULL : &changed_files);
         free(last_changed_file);
         last_changed_file = NULL;
     }
+    free_file_list(&changed_files);
+    changed_files = (FileList){0};
+    rescan_pending = false;
 }
 
-static void on_file_change(uv_fs_event_t *handle, const char *filename, int events, int status) {
-    if (status < 0) {
-        fprintf(stderr, "Error watching file: %s\n", uv_strerror(status));
-        return;
-    }
-    
-    if (filename && (events & UV_CHANGE) && strstr(filename, ".tsx")) {
+static bool is_component_file(const char* path) {
+    size_t len = strlen(path);
+    return len > 4 && strcmp(path + len - 4, ".tsx") == 0;
+}
+
+// Cycles run on finished saves and removals; intermediate writes and bare
+// creations are ignored so a half-saved file is never parsed. A directory
+// moved in or out takes its components along, so it triggers a cycle too.
+static void on_file_change(const char* path, int events) {
+    bool component = (events & (DIR_WATCH_WRITTEN | DIR_WATCH_REMOVED)) && is_component_file(path);
+    bool tree = (events & DIR_WATCH_ISDIR) && (events & (DIR_WATCH_CREATED | DIR_WATCH_REMOVED));
+    if (component || tree) {
         uv_timer_stop(&debounce_timer);
         if (last_changed_file) free(last_changed_file);
         
-        char full_path[512];
-        snprintf(full_path, sizeof(full_path), "./src/%s", filename);
-        last_changed_file = strdup(full_path);
+        last_changed_file = strdup(path);
         CHECK(last_changed_file);
+        if (tree) {
+            rescan_pending = true;
+        } else {
+            if (changed_files.count >= changed_files.capacity) {
+                changed_files.capacity = changed_files.capacity == 0 ? 16 : changed_files.capacity * 2;
+                changed_files.paths = realloc(changed_files.paths, changed_files.capacity * sizeof(char*));
+                CHECK(changed_files.paths);
+            }
+            changed_files.paths[changed_files.count] = strdup(path);
+            CHECK(changed_files.paths[changed_files.count]);
+            changed_files.count++;
+        }
         
         uv_timer_start(&debounce_timer, on_debounce_timeout, 50, 0);
     }
@@ -146,15 +240,23 @@ static void on_file_change(uv_fs_event_t *handle, const char *filename, int even
 
 void start_watching(uv_loop_t *loop, const char* directory) {
     uv_timer_init(loop, &debounce_timer);
-    uv_fs_event_init(loop, &fs_event);
-    uv_fs_event_start(&fs_event, on_file_change, directory, UV_FS_EVENT_RECURSIVE);
+    int r = dir_watch_start(loop, directory, on_file_change);
+    if (r != 0) {
+        fprintf(stderr, "%sCould not watch '%s': %s%s\n", KRED, directory, uv_strerror(r), KNRM);
+    }
     printf("🎨 %sdx-styles%s watching for component changes in '%s'...\n", KBLU, KNRM, directory);
 }
 
 void cleanup_watcher() {
     if (last_changed_file) free(last_changed_file);
+    free_file_list(&changed_files);
+    changed_files = (FileList){0};
     free_data_contents(&previous_data);
+    file_index_free(&file_index);
+    free(styles_buffer);
+    styles_buffer = NULL;
     uv_timer_stop(&debounce_timer);
     uv_close((uv_handle_t*)&debounce_timer, NULL);
-    uv_close((uv_handle_t*)&fs_event, NULL);
+    dir_watch_stop();
+    read_pipeline_shutdown();
 }
\ No newline at end of file
@@ -3,7 +3,17 @@
 
 #include "common.h"
 
+typedef void (*cycle_listener_cb)(const char* trigger_file, const DataLists* added, const DataLists* removed);
+
+// Rescans ./src. `trigger_file` names the change for the log and listeners.
 void run_modification_cycle(const char* trigger_file);
+// Re-reads only the files in `changed`, which is sorted and deduplicated in
+// place; files that no longer exist leave the index.
+void run_changed_files_cycle(const char* trigger_file, FileList* changed);
+const DataLists* watcher_current_data(void);
+const DataLists* watcher_file_data(const char* path);
+const void* watcher_styles_buffer(void);
+void watcher_add_listener(cycle_listener_cb cb);
 void start_watching(uv_loop_t *loop, const char* directory);
 void cleanup_watcher();
 